@@ -0,0 +1,611 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "Cbor.h"
+#include "JsonReader.h"
+#include "protocol\Protocol.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace JsDebug
+{
+    namespace
+    {
+        // Same nesting limit as the JSON parser.
+        const int kStackLimit = 1000;
+
+        const uint8_t kMajorUnsigned = 0 << 5;
+        const uint8_t kMajorNegative = 1 << 5;
+        const uint8_t kMajorByteString = 2 << 5;
+        const uint8_t kMajorString = 3 << 5;
+        const uint8_t kMajorArray = 4 << 5;
+        const uint8_t kMajorMap = 5 << 5;
+        const uint8_t kMajorTag = 6 << 5;
+        const uint8_t kMajorSimple = 7 << 5;
+
+        const uint8_t kAdditionalOneByte = 24;
+        const uint8_t kAdditionalTwoBytes = 25;
+        const uint8_t kAdditionalFourBytes = 26;
+        const uint8_t kAdditionalEightBytes = 27;
+        const uint8_t kAdditionalIndefinite = 31;
+
+        const uint8_t kFalse = kMajorSimple | 20;
+        const uint8_t kTrue = kMajorSimple | 21;
+        const uint8_t kNull = kMajorSimple | 22;
+        const uint8_t kUndefined = kMajorSimple | 23;
+        const uint8_t kHalf = kMajorSimple | kAdditionalTwoBytes;
+        const uint8_t kFloat = kMajorSimple | kAdditionalFourBytes;
+        const uint8_t kDouble = kMajorSimple | kAdditionalEightBytes;
+        const uint8_t kStop = kMajorSimple | kAdditionalIndefinite;
+
+        // An envelope is tag 24 (embedded CBOR) followed by a byte string whose length is always written in 32 bits,
+        // so that it can be filled in once the contents have been written.
+        const uint64_t kEnvelopeTag = 24;
+        const uint8_t kEnvelopeStart[] =
+        {
+            kMajorTag | kAdditionalOneByte,
+            static_cast<uint8_t>(kEnvelopeTag),
+            kMajorByteString | kAdditionalFourBytes,
+        };
+
+        void WriteBigEndian(uint64_t value, size_t size, std::string* out)
+        {
+            for (size_t i = size; i > 0; i--)
+            {
+                out->push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xff));
+            }
+        }
+
+        void WriteTypeAndArgument(uint8_t major, uint64_t value, std::string* out)
+        {
+            if (value < kAdditionalOneByte)
+            {
+                out->push_back(static_cast<char>(major | value));
+            }
+            else if (value <= 0xff)
+            {
+                out->push_back(static_cast<char>(major | kAdditionalOneByte));
+                WriteBigEndian(value, 1, out);
+            }
+            else if (value <= 0xffff)
+            {
+                out->push_back(static_cast<char>(major | kAdditionalTwoBytes));
+                WriteBigEndian(value, 2, out);
+            }
+            else if (value <= 0xffffffff)
+            {
+                out->push_back(static_cast<char>(major | kAdditionalFourBytes));
+                WriteBigEndian(value, 4, out);
+            }
+            else
+            {
+                out->push_back(static_cast<char>(major | kAdditionalEightBytes));
+                WriteBigEndian(value, 8, out);
+            }
+        }
+
+        void WriteInteger(int32_t value, std::string* out)
+        {
+            if (value >= 0)
+            {
+                WriteTypeAndArgument(kMajorUnsigned, static_cast<uint64_t>(value), out);
+            }
+            else
+            {
+                WriteTypeAndArgument(kMajorNegative, static_cast<uint64_t>(-(static_cast<int64_t>(value) + 1)), out);
+            }
+        }
+
+        void WriteDouble(double value, std::string* out)
+        {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            out->push_back(static_cast<char>(kDouble));
+            WriteBigEndian(bits, 8, out);
+        }
+
+        //
+        // Writes the CBOR form of each JSON token as it's read.
+        //
+        class CborWriter : public JsonReader::Handler
+        {
+        public:
+            explicit CborWriter(std::string* out)
+                : m_out(out)
+            {
+            }
+
+            bool OnObjectStart() override
+            {
+                m_out->append(reinterpret_cast<const char*>(kEnvelopeStart), sizeof(kEnvelopeStart));
+                m_envelopes.push_back(m_out->length());
+                m_out->append(4, '\0');
+                m_out->push_back(static_cast<char>(kMajorMap | kAdditionalIndefinite));
+                return true;
+            }
+
+            bool OnObjectEnd() override
+            {
+                m_out->push_back(static_cast<char>(kStop));
+
+                size_t lengthOffset = m_envelopes.back();
+                m_envelopes.pop_back();
+
+                uint64_t length = m_out->length() - lengthOffset - 4;
+                if (length > 0xffffffff)
+                {
+                    return false;
+                }
+
+                for (size_t i = 0; i < 4; i++)
+                {
+                    (*m_out)[lengthOffset + i] = static_cast<char>((length >> ((3 - i) * 8)) & 0xff);
+                }
+
+                return true;
+            }
+
+            bool OnArrayStart() override
+            {
+                m_out->push_back(static_cast<char>(kMajorArray | kAdditionalIndefinite));
+                return true;
+            }
+
+            bool OnArrayEnd() override
+            {
+                m_out->push_back(static_cast<char>(kStop));
+                return true;
+            }
+
+            bool OnKey(const char* key, size_t length) override
+            {
+                return OnString(key, length);
+            }
+
+            bool OnString(const char* str, size_t length) override
+            {
+                WriteTypeAndArgument(kMajorString, length, m_out);
+                m_out->append(str, length);
+                return true;
+            }
+
+            bool OnInteger(int32_t value) override
+            {
+                WriteInteger(value, m_out);
+                return true;
+            }
+
+            bool OnDouble(double value) override
+            {
+                WriteDouble(value, m_out);
+                return true;
+            }
+
+            bool OnBool(bool value) override
+            {
+                m_out->push_back(static_cast<char>(value ? kTrue : kFalse));
+                return true;
+            }
+
+            bool OnNull() override
+            {
+                m_out->push_back(static_cast<char>(kNull));
+                return true;
+            }
+
+        private:
+            std::string* m_out;
+
+            // Where the length of each envelope still open goes.
+            std::vector<size_t> m_envelopes;
+        };
+
+        //
+        // Builds the Value tree the dispatcher takes straight from the CBOR items.
+        //
+        class CborParser
+        {
+        public:
+            CborParser(const uint8_t* data, size_t length)
+                : m_pos(data)
+                , m_end(data + length)
+            {
+            }
+
+            std::unique_ptr<protocol::Value> Parse()
+            {
+                std::unique_ptr<protocol::Value> value = ParseValue(0);
+                if (value == nullptr || m_pos != m_end)
+                {
+                    return nullptr;
+                }
+
+                return value;
+            }
+
+        private:
+            bool ReadArgument(uint8_t additional, uint64_t* value)
+            {
+                size_t size = 0;
+
+                switch (additional)
+                {
+                case kAdditionalOneByte:
+                    size = 1;
+                    break;
+                case kAdditionalTwoBytes:
+                    size = 2;
+                    break;
+                case kAdditionalFourBytes:
+                    size = 4;
+                    break;
+                case kAdditionalEightBytes:
+                    size = 8;
+                    break;
+                default:
+                    if (additional >= kAdditionalOneByte)
+                    {
+                        return false;
+                    }
+
+                    *value = additional;
+                    return true;
+                }
+
+                if (static_cast<size_t>(m_end - m_pos) < size)
+                {
+                    return false;
+                }
+
+                uint64_t result = 0;
+                for (size_t i = 0; i < size; i++)
+                {
+                    result = (result << 8) | *m_pos++;
+                }
+
+                *value = result;
+                return true;
+            }
+
+            // Text strings are UTF-8; byte strings are the UTF-16 (little-endian) strings newer stacks also send.
+            bool ReadString(uint8_t major, uint8_t additional, protocol::String* result)
+            {
+                if (additional == kAdditionalIndefinite)
+                {
+                    std::string chunks;
+
+                    while (m_pos != m_end && *m_pos != kStop)
+                    {
+                        uint8_t initial = *m_pos++;
+                        if ((initial & 0xe0) != major)
+                        {
+                            return false;
+                        }
+
+                        uint64_t length = 0;
+                        if (!ReadArgument(initial & 0x1f, &length) ||
+                            length > static_cast<uint64_t>(m_end - m_pos))
+                        {
+                            return false;
+                        }
+
+                        chunks.append(reinterpret_cast<const char*>(m_pos), static_cast<size_t>(length));
+                        m_pos += length;
+                    }
+
+                    if (m_pos == m_end)
+                    {
+                        return false;
+                    }
+
+                    m_pos++;
+                    return MakeString(major, reinterpret_cast<const uint8_t*>(chunks.data()), chunks.length(), result);
+                }
+
+                uint64_t length = 0;
+                if (!ReadArgument(additional, &length) || length > static_cast<uint64_t>(m_end - m_pos))
+                {
+                    return false;
+                }
+
+                const uint8_t* data = m_pos;
+                m_pos += length;
+                return MakeString(major, data, static_cast<size_t>(length), result);
+            }
+
+            static bool MakeString(uint8_t major, const uint8_t* data, size_t length, protocol::String* result)
+            {
+                if (major == kMajorString)
+                {
+                    *result = protocol::String::fromUTF8(reinterpret_cast<const char*>(data), length);
+                    return true;
+                }
+
+                if (length % 2 != 0)
+                {
+                    return false;
+                }
+
+                std::basic_string<UChar> chars;
+                chars.reserve(length / 2);
+
+                for (size_t i = 0; i < length; i += 2)
+                {
+                    chars.push_back(static_cast<UChar>(data[i] | (data[i + 1] << 8)));
+                }
+
+                *result = protocol::String(std::move(chars));
+                return true;
+            }
+
+            std::unique_ptr<protocol::Value> MakeNumber(double value)
+            {
+                if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max() &&
+                    static_cast<int>(value) == value)
+                {
+                    return protocol::FundamentalValue::create(static_cast<int>(value));
+                }
+
+                return protocol::FundamentalValue::create(value);
+            }
+
+            std::unique_ptr<protocol::Value> ParseValue(int depth)
+            {
+                if (m_pos == m_end || depth > kStackLimit)
+                {
+                    return nullptr;
+                }
+
+                uint8_t initial = *m_pos++;
+                uint8_t major = initial & 0xe0;
+                uint8_t additional = initial & 0x1f;
+                uint64_t argument = 0;
+
+                switch (major)
+                {
+                case kMajorUnsigned:
+                    if (!ReadArgument(additional, &argument))
+                    {
+                        return nullptr;
+                    }
+
+                    return MakeNumber(static_cast<double>(argument));
+
+                case kMajorNegative:
+                    if (!ReadArgument(additional, &argument))
+                    {
+                        return nullptr;
+                    }
+
+                    return MakeNumber(-1.0 - static_cast<double>(argument));
+
+                case kMajorByteString:
+                case kMajorString:
+                {
+                    protocol::String value;
+                    if (!ReadString(major, additional, &value))
+                    {
+                        return nullptr;
+                    }
+
+                    return protocol::StringValue::create(value);
+                }
+
+                case kMajorArray:
+                    return ParseArray(additional, depth);
+
+                case kMajorMap:
+                    return ParseMap(additional, depth);
+
+                case kMajorTag:
+                    if (!ReadArgument(additional, &argument))
+                    {
+                        return nullptr;
+                    }
+
+                    return argument == kEnvelopeTag ? ParseEnvelope(depth) : ParseValue(depth + 1);
+
+                default:
+                    return ParseSimple(initial);
+                }
+            }
+
+            std::unique_ptr<protocol::Value> ParseEnvelope(int depth)
+            {
+                if (m_pos == m_end || (*m_pos & 0xe0) != kMajorByteString)
+                {
+                    return nullptr;
+                }
+
+                uint64_t length = 0;
+                if (!ReadArgument(*m_pos++ & 0x1f, &length) || length > static_cast<uint64_t>(m_end - m_pos))
+                {
+                    return nullptr;
+                }
+
+                const uint8_t* end = m_pos + length;
+                std::unique_ptr<protocol::Value> value = ParseValue(depth + 1);
+
+                return m_pos == end ? std::move(value) : nullptr;
+            }
+
+            std::unique_ptr<protocol::Value> ParseArray(uint8_t additional, int depth)
+            {
+                auto list = protocol::ListValue::create();
+
+                if (additional == kAdditionalIndefinite)
+                {
+                    while (m_pos != m_end && *m_pos != kStop)
+                    {
+                        std::unique_ptr<protocol::Value> item = ParseValue(depth + 1);
+                        if (item == nullptr)
+                        {
+                            return nullptr;
+                        }
+
+                        list->pushValue(std::move(item));
+                    }
+
+                    if (m_pos == m_end)
+                    {
+                        return nullptr;
+                    }
+
+                    m_pos++;
+                    return std::move(list);
+                }
+
+                uint64_t count = 0;
+                if (!ReadArgument(additional, &count) || count > static_cast<uint64_t>(m_end - m_pos))
+                {
+                    return nullptr;
+                }
+
+                for (uint64_t i = 0; i < count; i++)
+                {
+                    std::unique_ptr<protocol::Value> item = ParseValue(depth + 1);
+                    if (item == nullptr)
+                    {
+                        return nullptr;
+                    }
+
+                    list->pushValue(std::move(item));
+                }
+
+                return std::move(list);
+            }
+
+            std::unique_ptr<protocol::Value> ParseMap(uint8_t additional, int depth)
+            {
+                auto dictionary = protocol::DictionaryValue::create();
+
+                bool indefinite = additional == kAdditionalIndefinite;
+                uint64_t count = 0;
+                if (!indefinite && (!ReadArgument(additional, &count) || count > static_cast<uint64_t>(m_end - m_pos)))
+                {
+                    return nullptr;
+                }
+
+                for (uint64_t i = 0; indefinite || i < count; i++)
+                {
+                    if (m_pos == m_end)
+                    {
+                        return nullptr;
+                    }
+
+                    if (indefinite && *m_pos == kStop)
+                    {
+                        m_pos++;
+                        break;
+                    }
+
+                    uint8_t initial = *m_pos++;
+                    uint8_t major = initial & 0xe0;
+
+                    protocol::String key;
+                    if ((major != kMajorString && major != kMajorByteString) ||
+                        !ReadString(major, initial & 0x1f, &key))
+                    {
+                        return nullptr;
+                    }
+
+                    std::unique_ptr<protocol::Value> value = ParseValue(depth + 1);
+                    if (value == nullptr)
+                    {
+                        return nullptr;
+                    }
+
+                    dictionary->setValue(key, std::move(value));
+                }
+
+                return std::move(dictionary);
+            }
+
+            std::unique_ptr<protocol::Value> ParseSimple(uint8_t initial)
+            {
+                uint64_t bits = 0;
+
+                switch (initial)
+                {
+                case kFalse:
+                    return protocol::FundamentalValue::create(false);
+                case kTrue:
+                    return protocol::FundamentalValue::create(true);
+                case kNull:
+                case kUndefined:
+                    return protocol::Value::null();
+
+                case kHalf:
+                {
+                    if (!ReadArgument(kAdditionalTwoBytes, &bits))
+                    {
+                        return nullptr;
+                    }
+
+                    int exponent = (bits >> 10) & 0x1f;
+                    int mantissa = bits & 0x3ff;
+
+                    double value = exponent == 0
+                        ? std::ldexp(mantissa, -24)
+                        : exponent != 31
+                            ? std::ldexp(mantissa + 1024, exponent - 25)
+                            : mantissa == 0 ? std::numeric_limits<double>::infinity()
+                                            : std::numeric_limits<double>::quiet_NaN();
+
+                    return MakeNumber((bits & 0x8000) != 0 ? -value : value);
+                }
+
+                case kFloat:
+                {
+                    if (!ReadArgument(kAdditionalFourBytes, &bits))
+                    {
+                        return nullptr;
+                    }
+
+                    uint32_t floatBits = static_cast<uint32_t>(bits);
+                    float value = 0;
+                    std::memcpy(&value, &floatBits, sizeof(value));
+                    return MakeNumber(value);
+                }
+
+                case kDouble:
+                {
+                    if (!ReadArgument(kAdditionalEightBytes, &bits))
+                    {
+                        return nullptr;
+                    }
+
+                    double value = 0;
+                    std::memcpy(&value, &bits, sizeof(value));
+                    return MakeNumber(value);
+                }
+
+                default:
+                    return nullptr;
+                }
+            }
+
+            const uint8_t* m_pos;
+            const uint8_t* m_end;
+        };
+    }
+
+    bool Cbor::FromJson(const char* json, size_t length, std::string* cbor)
+    {
+        cbor->reserve(cbor->length() + length);
+
+        CborWriter writer(cbor);
+        return JsonReader::Read(json, length, &writer);
+    }
+
+    std::unique_ptr<protocol::Value> Cbor::Parse(const uint8_t* data, size_t length)
+    {
+        return CborParser(data, length).Parse();
+    }
+}
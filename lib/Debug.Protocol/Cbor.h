@@ -0,0 +1,35 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace JsDebug
+{
+    namespace protocol
+    {
+        class Value;
+    }
+
+    //
+    // The binary (CBOR, RFC 7049) encoding of protocol messages, in the form used by newer DevTools protocol stacks:
+    // maps are indefinite-length and wrapped in an envelope (tag 24 and a byte string with a 32-bit length), arrays
+    // are indefinite-length, strings are UTF-8 text, and numbers are integers when they fit in 32 bits and doubles
+    // otherwise. Messages are encoded in a single pass, without building a Value tree.
+    //
+    class Cbor
+    {
+    public:
+        // Returns false, leaving a partial result, if the message isn't valid JSON.
+        static bool FromJson(const char* json, size_t length, std::string* cbor);
+
+        // Returns nullptr if the message isn't valid CBOR or uses something the protocol has no value for.
+        static std::unique_ptr<protocol::Value> Parse(const uint8_t* data, size_t length);
+    };
+}
@@ -7,12 +7,18 @@
 import os
 import sys
 import argparse
+import gzip
+import hashlib
+import io
+import json
 import subprocess
 
 try:
     cmdline_parser = argparse.ArgumentParser()
     cmdline_parser.add_argument("--generator_script")
     cmdline_parser.add_argument("--markupsafe_dir")
+    cmdline_parser.add_argument("--output_base")
+    cmdline_parser.add_argument("--config")
     arg_options, args = cmdline_parser.parse_known_args()
 
     generator_script = arg_options.generator_script
@@ -23,12 +29,75 @@ try:
     if not markupsafe_dir:
         raise Exception("markupsafe directory must be specified")
 
+    output_base = arg_options.output_base
+    if not output_base:
+        raise Exception("Base output directory must be specified")
+
+    config_file = arg_options.config
+    if not config_file:
+        raise Exception("Config file must be specified")
+
 except Exception:
     exc = sys.exc_info()[1]
     sys.stderr.write("Failed to parse command-line arguments: %s\n\n" % exc)
     exit(1)
 
+def write_protocol_json(config_file, output_base):
+    # The protocol description is served by the /json/protocol endpoint. It's embedded minified and compressed with
+    # gzip, along with an ETag derived from its contents, so that serving it is just a matter of copying a buffer.
+    with open(config_file, "r") as f:
+        config = json.load(f)
+
+    protocol_file = os.path.join(os.path.dirname(os.path.abspath(config_file)), config["protocol"]["path"])
+    with open(protocol_file, "r") as f:
+        protocol = json.load(f)
+
+    minified = json.dumps(protocol, separators=(",", ":"), sort_keys=True).encode("utf-8")
+
+    buffer = io.BytesIO()
+    with gzip.GzipFile(fileobj=buffer, mode="wb", compresslevel=9, mtime=0) as f:
+        f.write(minified)
+    compressed = bytearray(buffer.getvalue())
+
+    version = protocol["version"]
+    lines = [
+        "// Generated by GenerateProtocol.py from %s. Do not edit." % os.path.basename(protocol_file),
+        "",
+        "#pragma once",
+        "",
+        "namespace JsDebug",
+        "{",
+        "    namespace protocol",
+        "    {",
+        "        const char kProtocolVersion[] = \"%s.%s\";" % (version["major"], version["minor"]),
+        "        const char kProtocolJsonETag[] = \"\\\"%s\\\"\";" % hashlib.sha1(minified).hexdigest(),
+        "        const size_t kProtocolJsonLength = %d;" % len(minified),
+        "        const unsigned char kProtocolJsonGzip[] =",
+        "        {",
+    ]
+
+    for i in range(0, len(compressed), 16):
+        lines.append("            " + " ".join("0x%02x," % b for b in compressed[i:i + 16]))
+
+    lines += [
+        "        };",
+        "    }",
+        "}",
+        "",
+    ]
+
+    output_dir = os.path.join(output_base, config["protocol"]["output"])
+    if not os.path.exists(output_dir):
+        os.makedirs(output_dir)
+
+    with open(os.path.join(output_dir, "ProtocolJson.h"), "w") as f:
+        f.write("\n".join(lines))
+
+write_protocol_json(config_file, output_base)
+
 env = os.environ.copy()
 path = os.path.abspath(markupsafe_dir)
 env["PYTHONPATH"] = env.get("PYTHONPATH", "") + ";" + path
-subprocess.Popen([sys.executable, generator_script] + args, env=env)
+subprocess.Popen(
+    [sys.executable, generator_script, "--output_base", output_base, "--config", config_file] + args,
+    env=env)
@@ -0,0 +1,445 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "JsonReader.h"
+#include "NumberFormat.h"
+
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace JsDebug
+{
+    namespace
+    {
+        // Same nesting limit as the JSON parser.
+        const int kStackLimit = 1000;
+
+        // Integers with no more digits than this can't overflow while they're accumulated.
+        const ptrdiff_t kMaxIntegerDigits = 10;
+
+        // U+FFFD, substituted for unpaired surrogates.
+        const uint32_t kReplacementCharacter = 0xfffd;
+
+        void AppendUtf8(uint32_t codePoint, std::string* out)
+        {
+            if (codePoint < 0x80)
+            {
+                out->push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                out->push_back(static_cast<char>(0xc0 | (codePoint >> 6)));
+                out->push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                out->push_back(static_cast<char>(0xe0 | (codePoint >> 12)));
+                out->push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+                out->push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+            }
+            else
+            {
+                out->push_back(static_cast<char>(0xf0 | (codePoint >> 18)));
+                out->push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f)));
+                out->push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+                out->push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+            }
+        }
+
+        class Reader
+        {
+        public:
+            Reader(const char* json, size_t length, JsonReader::Handler* handler)
+                : m_pos(json)
+                , m_end(json + length)
+                , m_handler(handler)
+            {
+            }
+
+            bool Read()
+            {
+                SkipWhitespace();
+                if (!ReadValue(0))
+                {
+                    return false;
+                }
+
+                SkipWhitespace();
+                return m_pos == m_end;
+            }
+
+        private:
+            bool ReadValue(int depth)
+            {
+                if (m_pos == m_end || depth > kStackLimit)
+                {
+                    return false;
+                }
+
+                const char* str = nullptr;
+                size_t length = 0;
+
+                switch (*m_pos)
+                {
+                case '{':
+                    return ReadObject(depth);
+                case '[':
+                    return ReadArray(depth);
+                case '"':
+                    return ReadString(&str, &length) && m_handler->OnString(str, length);
+                case 't':
+                    return ReadLiteral("true") && m_handler->OnBool(true);
+                case 'f':
+                    return ReadLiteral("false") && m_handler->OnBool(false);
+                case 'n':
+                    return ReadLiteral("null") && m_handler->OnNull();
+                default:
+                    return ReadNumber();
+                }
+            }
+
+            bool ReadObject(int depth)
+            {
+                m_pos++;
+                if (!m_handler->OnObjectStart())
+                {
+                    return false;
+                }
+
+                SkipWhitespace();
+                if (m_pos != m_end && *m_pos == '}')
+                {
+                    m_pos++;
+                    return m_handler->OnObjectEnd();
+                }
+
+                while (true)
+                {
+                    const char* key = nullptr;
+                    size_t length = 0;
+                    if (m_pos == m_end || *m_pos != '"' || !ReadString(&key, &length) || !m_handler->OnKey(key, length))
+                    {
+                        return false;
+                    }
+
+                    SkipWhitespace();
+                    if (m_pos == m_end || *m_pos != ':')
+                    {
+                        return false;
+                    }
+
+                    m_pos++;
+                    SkipWhitespace();
+                    if (!ReadValue(depth + 1))
+                    {
+                        return false;
+                    }
+
+                    SkipWhitespace();
+                    if (m_pos != m_end && *m_pos == ',')
+                    {
+                        m_pos++;
+                        SkipWhitespace();
+                        continue;
+                    }
+
+                    if (m_pos != m_end && *m_pos == '}')
+                    {
+                        m_pos++;
+                        return m_handler->OnObjectEnd();
+                    }
+
+                    return false;
+                }
+            }
+
+            bool ReadArray(int depth)
+            {
+                m_pos++;
+                if (!m_handler->OnArrayStart())
+                {
+                    return false;
+                }
+
+                SkipWhitespace();
+                if (m_pos != m_end && *m_pos == ']')
+                {
+                    m_pos++;
+                    return m_handler->OnArrayEnd();
+                }
+
+                while (true)
+                {
+                    if (!ReadValue(depth + 1))
+                    {
+                        return false;
+                    }
+
+                    SkipWhitespace();
+                    if (m_pos != m_end && *m_pos == ',')
+                    {
+                        m_pos++;
+                        SkipWhitespace();
+                        continue;
+                    }
+
+                    if (m_pos != m_end && *m_pos == ']')
+                    {
+                        m_pos++;
+                        return m_handler->OnArrayEnd();
+                    }
+
+                    return false;
+                }
+            }
+
+            bool ReadString(const char** str, size_t* length)
+            {
+                const char* start = ++m_pos;
+
+                // Most strings have nothing to unescape and are passed straight from the message.
+                while (m_pos != m_end && *m_pos != '"' && *m_pos != '\\')
+                {
+                    if (static_cast<unsigned char>(*m_pos) < 0x20)
+                    {
+                        return false;
+                    }
+
+                    m_pos++;
+                }
+
+                if (m_pos == m_end)
+                {
+                    return false;
+                }
+
+                if (*m_pos == '"')
+                {
+                    *str = start;
+                    *length = m_pos - start;
+                    m_pos++;
+                    return true;
+                }
+
+                m_buffer.assign(start, m_pos - start);
+
+                while (m_pos != m_end && *m_pos != '"')
+                {
+                    char c = *m_pos++;
+
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        return false;
+                    }
+
+                    if (c != '\\')
+                    {
+                        m_buffer.push_back(c);
+                        continue;
+                    }
+
+                    if (m_pos == m_end)
+                    {
+                        return false;
+                    }
+
+                    switch (*m_pos++)
+                    {
+                    case '"':
+                        m_buffer.push_back('"');
+                        break;
+                    case '\\':
+                        m_buffer.push_back('\\');
+                        break;
+                    case '/':
+                        m_buffer.push_back('/');
+                        break;
+                    case 'b':
+                        m_buffer.push_back('\b');
+                        break;
+                    case 'f':
+                        m_buffer.push_back('\f');
+                        break;
+                    case 'n':
+                        m_buffer.push_back('\n');
+                        break;
+                    case 'r':
+                        m_buffer.push_back('\r');
+                        break;
+                    case 't':
+                        m_buffer.push_back('\t');
+                        break;
+                    case 'u':
+                    {
+                        uint32_t codePoint = 0;
+                        if (!ReadHex(&codePoint))
+                        {
+                            return false;
+                        }
+
+                        // A surrogate pair is written as two escapes. An unpaired surrogate can't be encoded as UTF-8,
+                        // so it becomes a replacement character.
+                        uint32_t low = 0;
+                        if (codePoint >= 0xd800 && codePoint < 0xdc00 &&
+                            m_end - m_pos >= 6 && m_pos[0] == '\\' && m_pos[1] == 'u')
+                        {
+                            const char* saved = m_pos;
+                            m_pos += 2;
+
+                            if (ReadHex(&low) && low >= 0xdc00 && low < 0xe000)
+                            {
+                                codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                            }
+                            else
+                            {
+                                m_pos = saved;
+                            }
+                        }
+
+                        if (codePoint >= 0xd800 && codePoint < 0xe000)
+                        {
+                            codePoint = kReplacementCharacter;
+                        }
+
+                        AppendUtf8(codePoint, &m_buffer);
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+                }
+
+                if (m_pos == m_end)
+                {
+                    return false;
+                }
+
+                m_pos++;
+                *str = m_buffer.data();
+                *length = m_buffer.length();
+                return true;
+            }
+
+            bool ReadHex(uint32_t* value)
+            {
+                if (m_end - m_pos < 4)
+                {
+                    return false;
+                }
+
+                uint32_t result = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    char c = *m_pos++;
+                    result <<= 4;
+
+                    if (c >= '0' && c <= '9')
+                    {
+                        result |= c - '0';
+                    }
+                    else if (c >= 'a' && c <= 'f')
+                    {
+                        result |= c - 'a' + 10;
+                    }
+                    else if (c >= 'A' && c <= 'F')
+                    {
+                        result |= c - 'A' + 10;
+                    }
+                    else
+                    {
+                        return false;
+                    }
+                }
+
+                *value = result;
+                return true;
+            }
+
+            bool ReadNumber()
+            {
+                const char* start = m_pos;
+                bool integer = true;
+
+                if (*m_pos == '-')
+                {
+                    m_pos++;
+                }
+
+                const char* digits = m_pos;
+                while (m_pos != m_end)
+                {
+                    char c = *m_pos;
+                    if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+                    {
+                        integer = false;
+                    }
+                    else if (c < '0' || c > '9')
+                    {
+                        break;
+                    }
+
+                    m_pos++;
+                }
+
+                // Ids, line numbers and the like are read here without going through the full number grammar.
+                if (integer && m_pos != digits && m_pos - digits <= kMaxIntegerDigits &&
+                    (*digits != '0' || m_pos - digits == 1))
+                {
+                    int64_t value = 0;
+                    for (const char* c = digits; c != m_pos; c++)
+                    {
+                        value = value * 10 + (*c - '0');
+                    }
+
+                    if (*start == '-')
+                    {
+                        value = -value;
+                    }
+
+                    if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max())
+                    {
+                        return m_handler->OnInteger(static_cast<int32_t>(value));
+                    }
+                }
+
+                double value = 0;
+                return NumberFormat::ParseDouble(start, m_pos - start, &value) && m_handler->OnDouble(value);
+            }
+
+            bool ReadLiteral(const char* literal)
+            {
+                size_t length = std::strlen(literal);
+                if (static_cast<size_t>(m_end - m_pos) < length || std::strncmp(m_pos, literal, length) != 0)
+                {
+                    return false;
+                }
+
+                m_pos += length;
+                return true;
+            }
+
+            void SkipWhitespace()
+            {
+                while (m_pos != m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r' || *m_pos == '\n'))
+                {
+                    m_pos++;
+                }
+            }
+
+            const char* m_pos;
+            const char* m_end;
+            JsonReader::Handler* m_handler;
+
+            // Holds strings that had escapes in them while they're unescaped.
+            std::string m_buffer;
+        };
+    }
+
+    bool JsonReader::Read(const char* json, size_t length, Handler* handler)
+    {
+        return Reader(json, length, handler).Read();
+    }
+}
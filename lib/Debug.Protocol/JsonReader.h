@@ -0,0 +1,42 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace JsDebug
+{
+    //
+    // Reads a JSON message in a single pass and reports each token to a handler as it goes, without building a Value
+    // tree. Strings (and keys) are passed unescaped as UTF-8; they point into the message unless they had escapes in
+    // them, and are only valid for the duration of the call. Integers that fit in 32 bits are reported as such.
+    //
+    class JsonReader
+    {
+    public:
+        class Handler
+        {
+        public:
+            virtual ~Handler() {}
+
+            // Returning false from any of these stops the reader, which then fails.
+            virtual bool OnObjectStart() = 0;
+            virtual bool OnObjectEnd() = 0;
+            virtual bool OnArrayStart() = 0;
+            virtual bool OnArrayEnd() = 0;
+            virtual bool OnKey(const char* key, size_t length) = 0;
+            virtual bool OnString(const char* str, size_t length) = 0;
+            virtual bool OnInteger(int32_t value) = 0;
+            virtual bool OnDouble(double value) = 0;
+            virtual bool OnBool(bool value) = 0;
+            virtual bool OnNull() = 0;
+        };
+
+        // Returns false if the message isn't exactly one valid JSON value, or the handler stopped it.
+        static bool Read(const char* json, size_t length, Handler* handler);
+    };
+}
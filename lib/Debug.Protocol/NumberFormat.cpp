@@ -0,0 +1,334 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "NumberFormat.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace JsDebug
+{
+    namespace
+    {
+        // Any double reads back from this many significant digits, and any decimal with no more than the safe number
+        // of digits reads back from its double.
+        const int kMaxSignificantDigits = 17;
+        const int kSafeSignificantDigits = 15;
+
+        // Integral doubles below this are exact, and are written as integers.
+        const double kMaxExactInteger = 9007199254740992.0;
+
+        // Number.toString uses exponential notation when the decimal point would fall outside this range.
+        const int kMaxFixedPoint = 21;
+        const int kMinFixedPoint = -6;
+
+        // Exponents beyond this are out of range of a double whatever the digits are.
+        const long kMaxParsedExponent = 100000;
+
+        bool IsDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        const char* SkipDigits(const char* c, const char* end)
+        {
+            while (c != end && IsDigit(*c))
+            {
+                c++;
+            }
+
+            return c;
+        }
+
+        size_t Copy(const char* str, char* buffer)
+        {
+            size_t length = std::strlen(str);
+            std::memcpy(buffer, str, length);
+            return length;
+        }
+
+        // Gets the significant digits of a positive value rounded to the given precision, without trailing zeros, and
+        // the decimal exponent of the first one. Only digits are taken from printf's output, so whatever decimal
+        // point the locale has never gets through.
+        int GetDigits(double value, int precision, char* digits, int* exponent)
+        {
+            char formatted[64];
+            std::snprintf(formatted, sizeof(formatted), "%.*e", precision - 1, value);
+
+            int count = 0;
+            const char* c = formatted;
+            for (; *c != '\0' && *c != 'e'; c++)
+            {
+                if (*c >= '0' && *c <= '9')
+                {
+                    digits[count++] = *c;
+                }
+            }
+
+            int sign = 1;
+            int result = 0;
+            if (*c == 'e')
+            {
+                c++;
+                if (*c == '-' || *c == '+')
+                {
+                    sign = *c++ == '-' ? -1 : 1;
+                }
+
+                for (; *c >= '0' && *c <= '9'; c++)
+                {
+                    result = result * 10 + (*c - '0');
+                }
+            }
+
+            while (count > 1 && digits[count - 1] == '0')
+            {
+                count--;
+            }
+
+            *exponent = sign * result;
+            return count;
+        }
+
+        bool RoundTrips(double value, const char* digits, int count, int exponent)
+        {
+            // The digits are read back as an integer with an exponent, which doesn't involve the decimal point either.
+            char text[64];
+            std::memcpy(text, digits, count);
+            std::snprintf(text + count, sizeof(text) - count, "e%d", exponent - (count - 1));
+
+            return std::strtod(text, nullptr) == value;
+        }
+    }
+
+    size_t NumberFormat::FormatInteger(int64_t value, char* buffer)
+    {
+        if (value >= 0)
+        {
+            return FormatUnsigned(static_cast<uint64_t>(value), buffer);
+        }
+
+        buffer[0] = '-';
+        return 1 + FormatUnsigned(0 - static_cast<uint64_t>(value), buffer + 1);
+    }
+
+    size_t NumberFormat::FormatUnsigned(uint64_t value, char* buffer)
+    {
+        char reversed[20];
+        size_t count = 0;
+
+        do
+        {
+            reversed[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            buffer[i] = reversed[count - 1 - i];
+        }
+
+        return count;
+    }
+
+    size_t NumberFormat::FormatDouble(double value, char* buffer)
+    {
+        if (std::isnan(value))
+        {
+            return Copy("NaN", buffer);
+        }
+
+        if (std::isinf(value))
+        {
+            return Copy(value < 0 ? "-Infinity" : "Infinity", buffer);
+        }
+
+        // Line numbers, ids and timestamps make up most of what gets here.
+        if (std::fabs(value) < kMaxExactInteger && std::floor(value) == value)
+        {
+            return FormatInteger(static_cast<int64_t>(value), buffer);
+        }
+
+        size_t length = 0;
+        if (value < 0)
+        {
+            buffer[length++] = '-';
+            value = -value;
+        }
+
+        // If the shortest form has no more digits than are always safe, it's the safe rounding without its trailing
+        // zeros. Otherwise the closest 16 digit decimal reads back if any does, and 17 digits always do. Subnormals
+        // have less precision than that, so they're searched from a single digit up.
+        char digits[kMaxSignificantDigits];
+        int count = 0;
+        int exponent = 0;
+        int first = value < DBL_MIN ? 1 : kSafeSignificantDigits;
+        for (int precision = first; precision <= kMaxSignificantDigits; precision++)
+        {
+            count = GetDigits(value, precision, digits, &exponent);
+            if (RoundTrips(value, digits, count, exponent))
+            {
+                break;
+            }
+        }
+
+        int point = exponent + 1;
+
+        if (count <= point && point <= kMaxFixedPoint)
+        {
+            std::memcpy(buffer + length, digits, count);
+            length += count;
+            std::memset(buffer + length, '0', point - count);
+            length += point - count;
+        }
+        else if (0 < point && point <= kMaxFixedPoint)
+        {
+            std::memcpy(buffer + length, digits, point);
+            length += point;
+            buffer[length++] = '.';
+            std::memcpy(buffer + length, digits + point, count - point);
+            length += count - point;
+        }
+        else if (kMinFixedPoint < point && point <= 0)
+        {
+            buffer[length++] = '0';
+            buffer[length++] = '.';
+            std::memset(buffer + length, '0', -point);
+            length += -point;
+            std::memcpy(buffer + length, digits, count);
+            length += count;
+        }
+        else
+        {
+            buffer[length++] = digits[0];
+            if (count > 1)
+            {
+                buffer[length++] = '.';
+                std::memcpy(buffer + length, digits + 1, count - 1);
+                length += count - 1;
+            }
+
+            buffer[length++] = 'e';
+            buffer[length++] = exponent < 0 ? '-' : '+';
+            length += FormatUnsigned(static_cast<uint64_t>(exponent < 0 ? -exponent : exponent), buffer + length);
+        }
+
+        return length;
+    }
+
+    bool NumberFormat::ParseDouble(const char* str, size_t length, double* value)
+    {
+        const char* c = str;
+        const char* end = str + length;
+
+        bool negative = c != end && *c == '-';
+        if (negative)
+        {
+            c++;
+        }
+
+        const char* integer = c;
+        c = SkipDigits(c, end);
+        size_t integerLength = c - integer;
+        if (integerLength == 0 || (integer[0] == '0' && integerLength > 1))
+        {
+            return false;
+        }
+
+        const char* fraction = c;
+        size_t fractionLength = 0;
+        if (c != end && *c == '.')
+        {
+            fraction = ++c;
+            c = SkipDigits(c, end);
+            fractionLength = c - fraction;
+            if (fractionLength == 0)
+            {
+                return false;
+            }
+        }
+
+        bool hasExponent = c != end && (*c == 'e' || *c == 'E');
+        long exponent = 0;
+        if (hasExponent)
+        {
+            c++;
+            bool negativeExponent = c != end && *c == '-';
+            if (c != end && (*c == '-' || *c == '+'))
+            {
+                c++;
+            }
+
+            const char* digits = c;
+            for (; c != end && IsDigit(*c); c++)
+            {
+                exponent = (std::min)(exponent * 10 + (*c - '0'), kMaxParsedExponent);
+            }
+
+            if (c == digits)
+            {
+                return false;
+            }
+
+            if (negativeExponent)
+            {
+                exponent = -exponent;
+            }
+        }
+
+        if (c != end)
+        {
+            return false;
+        }
+
+        // Integers with no more digits than are always safe are exact, which covers ids and nearly everything else
+        // in a command.
+        if (fractionLength == 0 && !hasExponent && integerLength <= kSafeSignificantDigits)
+        {
+            int64_t result = 0;
+            for (const char* digit = integer; digit != fraction; digit++)
+            {
+                result = result * 10 + (*digit - '0');
+            }
+
+            *value = negative ? -static_cast<double>(result) : static_cast<double>(result);
+            return true;
+        }
+
+        // Anything else is handed to strtod as an integer and an exponent, so the decimal point the locale has doesn't
+        // matter.
+        char local[64];
+        std::string large;
+        size_t textLength = 1 + integerLength + fractionLength + 1 + kBufferSize + 1;
+        if (textLength > sizeof(local))
+        {
+            large.resize(textLength);
+        }
+
+        char* text = textLength > sizeof(local) ? &large[0] : local;
+        size_t pos = 0;
+
+        if (negative)
+        {
+            text[pos++] = '-';
+        }
+
+        std::memcpy(text + pos, integer, integerLength);
+        pos += integerLength;
+        std::memcpy(text + pos, fraction, fractionLength);
+        pos += fractionLength;
+        text[pos++] = 'e';
+        pos += FormatInteger(static_cast<int64_t>(exponent) - static_cast<int64_t>(fractionLength), text + pos);
+        text[pos] = '\0';
+
+        *value = std::strtod(text, nullptr);
+        return true;
+    }
+}
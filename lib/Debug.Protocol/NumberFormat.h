@@ -0,0 +1,32 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace JsDebug
+{
+    //
+    // Number formatting and parsing for protocol messages that doesn't depend on the process locale. Doubles are
+    // written with the fewest significant digits that read back as the same value, in the form JavaScript's
+    // Number.toString uses, and read with the JSON number grammar.
+    //
+    class NumberFormat
+    {
+    public:
+        // Large enough for anything these write.
+        static const size_t kBufferSize = 32;
+
+        // Each returns the number of characters written. The result isn't null-terminated.
+        static size_t FormatInteger(int64_t value, char* buffer);
+        static size_t FormatUnsigned(uint64_t value, char* buffer);
+        static size_t FormatDouble(double value, char* buffer);
+
+        // Returns false if the string isn't exactly one JSON number.
+        static bool ParseDouble(const char* str, size_t length, double* value);
+    };
+}
@@ -11,6 +11,12 @@
 
 namespace JsDebug
 {
+    namespace
+    {
+        const size_t kFnvOffsetBasis = sizeof(size_t) == 8 ? static_cast<size_t>(14695981039346656037ULL) : 2166136261U;
+        const size_t kFnvPrime = sizeof(size_t) == 8 ? static_cast<size_t>(1099511628211ULL) : 16777619U;
+    }
+
     String16::String16()
     {
     }
@@ -39,6 +45,82 @@ namespace JsDebug
     {
     }
 
+    String16::String16(std::basic_string<UChar>&& impl)
+        : m_impl(std::move(impl))
+    {
+    }
+
+    String16 String16::fromUTF8(const char* str, size_t length)
+    {
+        std::basic_string<UChar> impl;
+        impl.reserve(length);
+
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+        const unsigned char* end = p + length;
+
+        while (p < end)
+        {
+            uint32_t c = *p++;
+            int trailing = 0;
+
+            // The smallest code point each sequence length can encode; anything below it is an overlong form.
+            uint32_t minimum = 0;
+
+            if (c >= 0xf8)
+            {
+                // No valid sequence starts with these.
+                impl.push_back(0xfffd);
+                continue;
+            }
+            else if (c >= 0xf0)
+            {
+                c &= 0x07;
+                trailing = 3;
+                minimum = 0x10000;
+            }
+            else if (c >= 0xe0)
+            {
+                c &= 0x0f;
+                trailing = 2;
+                minimum = 0x800;
+            }
+            else if (c >= 0xc0)
+            {
+                c &= 0x1f;
+                trailing = 1;
+                minimum = 0x80;
+            }
+            else if (c >= 0x80)
+            {
+                // Stray continuation byte
+                impl.push_back(0xfffd);
+                continue;
+            }
+
+            for (; trailing > 0 && p < end && (*p & 0xc0) == 0x80; trailing--)
+            {
+                c = (c << 6) | (*p++ & 0x3f);
+            }
+
+            if (trailing != 0 || c < minimum || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff))
+            {
+                impl.push_back(0xfffd);
+            }
+            else if (c >= 0x10000)
+            {
+                c -= 0x10000;
+                impl.push_back(static_cast<UChar>(0xd800 + (c >> 10)));
+                impl.push_back(static_cast<UChar>(0xdc00 + (c & 0x3ff)));
+            }
+            else
+            {
+                impl.push_back(static_cast<UChar>(c));
+            }
+        }
+
+        return String16(std::move(impl));
+    }
+
     String16 String16::operator+(const String16& other) const
     {
         return String16(m_impl + other.m_impl);
@@ -66,11 +148,60 @@ namespace JsDebug
 
     size_t String16::hash() const
     {
-        std::hash<std::basic_string<UChar>> hash;
-        return hash(m_impl);
+        // FNV-1a over the code units, without a copy. The protocol dispatcher and the Value maps look everything up
+        // by these, and std::hash isn't available for strings of uint16_t on every standard library.
+        size_t hash = kFnvOffsetBasis;
+        for (UChar c : m_impl)
+        {
+            hash = (hash ^ c) * kFnvPrime;
+        }
+
+        return hash;
     }
 
-    size_t String16::find(String16 str) const
+    std::string String16::toUTF8() const
+    {
+        std::string result;
+        result.reserve(m_impl.length());
+
+        for (size_t i = 0; i < m_impl.length(); i++)
+        {
+            uint32_t c = m_impl[i];
+
+            if (c >= 0xd800 && c < 0xdc00 && i + 1 < m_impl.length() &&
+                m_impl[i + 1] >= 0xdc00 && m_impl[i + 1] < 0xe000)
+            {
+                c = 0x10000 + ((c - 0xd800) << 10) + (m_impl[++i] - 0xdc00);
+            }
+
+            if (c < 0x80)
+            {
+                result.push_back(static_cast<char>(c));
+            }
+            else if (c < 0x800)
+            {
+                result.push_back(static_cast<char>(0xc0 | (c >> 6)));
+                result.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+            }
+            else if (c < 0x10000)
+            {
+                result.push_back(static_cast<char>(0xe0 | (c >> 12)));
+                result.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+                result.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+            }
+            else
+            {
+                result.push_back(static_cast<char>(0xf0 | (c >> 18)));
+                result.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3f)));
+                result.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+                result.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+            }
+        }
+
+        return result;
+    }
+
+    size_t String16::find(const String16& str) const
     {
         return m_impl.find(str.m_impl);
     }
@@ -86,7 +217,7 @@ namespace JsDebug
 
     void String16Builder::append(const String16& s)
     {
-        m_buffer.insert(m_buffer.end(), s.characters16(), s.characters16() + s.length());
+        m_buffer.append(s.characters16(), s.length());
     }
 
     void String16Builder::append(UChar c)
@@ -106,6 +237,13 @@ namespace JsDebug
 
     String16 String16Builder::toString()
     {
-        return String16(m_buffer.data(), m_buffer.size());
+        return String16(m_buffer);
+    }
+
+    String16 String16Builder::take()
+    {
+        String16 result(std::move(m_buffer));
+        m_buffer.clear();
+        return result;
     }
 }
@@ -26,6 +26,9 @@ namespace JsDebug
         String16(const char* str);
         String16(const char* str, size_t length);
         explicit String16(const std::basic_string<UChar>& impl);
+        explicit String16(std::basic_string<UChar>&& impl);
+
+        static String16 fromUTF8(const char* str, size_t length);
 
         String16 operator+(const String16& other) const;
         bool operator==(const String16& other) const;
@@ -35,7 +38,9 @@ namespace JsDebug
         bool empty() const;
         size_t hash() const;
 
-        size_t find(String16 str) const;
+        std::string toUTF8() const;
+
+        size_t find(const String16& str) const;
         String16 substring(size_t pos, size_t len) const;
 
     private:
@@ -57,8 +62,11 @@ namespace JsDebug
         void reserve(size_t len);
         String16 toString();
 
+        // Like toString, but hands over the buffer instead of copying it and leaves the builder empty.
+        String16 take();
+
     private:
-        std::vector<UChar> m_buffer;
+        std::basic_string<UChar> m_buffer;
     };
 }
 
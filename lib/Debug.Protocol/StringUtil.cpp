@@ -4,9 +4,10 @@
 //---------------------------------------------------------------------------------------------------
 
 #include "StringUtil.h"
+#include "NumberFormat.h"
 #include "protocol\Protocol.h"
 
-#include <sstream>
+#include <cstring>
 
 //
 // This file contains interfaces required by the `inspector_protocol` generated code.
@@ -23,36 +24,51 @@ namespace JsDebug
 
         String StringUtil::fromInteger(int number)
         {
-            std::ostringstream o;
-            o << number;
-            return String(o.str().c_str());
+            char buffer[NumberFormat::kBufferSize];
+            return String(buffer, NumberFormat::FormatInteger(number, buffer));
         }
 
         String StringUtil::fromInteger(size_t number)
         {
-            std::ostringstream o;
-            o << number;
-            return String(o.str().c_str());
+            char buffer[NumberFormat::kBufferSize];
+            return String(buffer, NumberFormat::FormatUnsigned(number, buffer));
         }
 
         String StringUtil::fromDouble(double number)
         {
-            std::ostringstream o;
-            o << number;
-            return String(o.str().c_str());
+            char buffer[NumberFormat::kBufferSize];
+            return String(buffer, NumberFormat::FormatDouble(number, buffer));
         }
 
         double StringUtil::toDouble(const char* s, size_t len, bool* isOk)
         {
-            std::istringstream i(std::string(s, len));
-            double x;
-            *isOk = !!(i >> x);
-            return x;
+            double value = 0;
+            *isOk = NumberFormat::ParseDouble(s, len, &value);
+            return value;
         }
 
         size_t StringUtil::find(const String& s, const char* needle)
         {
-            return s.find(needle);
+            // The dispatcher splits every method name on its dot with this, so it doesn't convert the needle first.
+            const UChar* chars = s.characters16();
+            size_t length = s.length();
+            size_t needleLength = std::strlen(needle);
+
+            for (size_t i = 0; i + needleLength <= length; i++)
+            {
+                size_t matched = 0;
+                while (matched < needleLength && chars[i + matched] == static_cast<unsigned char>(needle[matched]))
+                {
+                    matched++;
+                }
+
+                if (matched == needleLength)
+                {
+                    return i;
+                }
+            }
+
+            return kNotFound;
         }
 
         size_t StringUtil::find(const String& s, const String& needle)
@@ -96,7 +112,9 @@ namespace JsDebug
 
         String StringUtil::builderToString(StringBuilder& builder)
         {
-            return builder.toString();
+            // The generated code is done with a builder once it has been converted, and the result can be as large as
+            // a script's source, so it's handed over rather than copied.
+            return builder.take();
         }
 
         std::unique_ptr<protocol::Value> StringUtil::parseJSON(const String16& json)
@@ -0,0 +1,303 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "AsyncStackTracker.h"
+
+namespace JsDebug
+{
+    namespace
+    {
+        // Approximate heap cost of the bookkeeping for a node and a task, including hash table overhead.
+        const size_t kNodeCost = 4 * sizeof(uint32_t) + sizeof(void*);
+        const size_t kTaskCost = 4 * sizeof(void*) + sizeof(uint32_t);
+        const size_t kSiteOverhead = 4 * sizeof(void*) + sizeof(uint32_t);
+
+        const char* OrEmpty(const char* str)
+        {
+            return str != nullptr ? str : "";
+        }
+    }
+
+    AsyncStackTracker::AsyncStackTracker(size_t maxBytes)
+        : m_maxBytes(maxBytes)
+        , m_maxDepth(0)
+        , m_usedBytes(0)
+        , m_droppedCount(0)
+    {
+    }
+
+    AsyncStackTracker::~AsyncStackTracker()
+    {
+    }
+
+    void AsyncStackTracker::SetMaxDepth(int maxDepth)
+    {
+        if (maxDepth <= 0)
+        {
+            Clear();
+            m_maxDepth = 0;
+            return;
+        }
+
+        m_maxDepth = static_cast<uint32_t>(maxDepth);
+    }
+
+    void AsyncStackTracker::TaskScheduled(
+        const void* task,
+        const char* description,
+        const char* url,
+        int lineNumber,
+        int columnNumber)
+    {
+        if (m_maxDepth == 0 || task == nullptr)
+        {
+            return;
+        }
+
+        // A task can be scheduled again (e.g. a repeating timer); the latest scheduling point wins.
+        auto existing = m_tasks.find(task);
+        if (existing != m_tasks.end())
+        {
+            ReleaseChain(existing->second);
+            m_tasks.erase(existing);
+            m_usedBytes -= kTaskCost;
+        }
+
+        uint32_t parent = m_running.empty() ? kNoChain : m_running.back().chain;
+
+        // Cutting the chain here rather than copying its newest part keeps scheduling O(1). A long chain of tasks
+        // that each schedule the next one therefore shows between one and the maximum depth of segments.
+        if (parent != kNoChain && m_nodes[parent].depth >= m_maxDepth)
+        {
+            parent = kNoChain;
+        }
+
+        Site site = { OrEmpty(description), OrEmpty(url), lineNumber, columnNumber };
+
+        size_t cost = kNodeCost + kTaskCost;
+        if (m_sites.find(site) == m_sites.end())
+        {
+            cost += SiteCost(site);
+        }
+
+        if (m_usedBytes + cost > m_maxBytes)
+        {
+            m_droppedCount++;
+            return;
+        }
+
+        size_t siteCost = 0;
+        const Site* interned = AcquireSite(std::move(site), &siteCost);
+
+        m_tasks.emplace(task, AllocateNode(interned, parent));
+        m_usedBytes += kNodeCost + kTaskCost + siteCost;
+    }
+
+    void AsyncStackTracker::TaskStarted(const void* task)
+    {
+        if (m_maxDepth == 0)
+        {
+            return;
+        }
+
+        // Untracked tasks still get an entry, so that work they schedule isn't attributed to an outer task.
+        uint32_t chain = kNoChain;
+
+        auto it = m_tasks.find(task);
+        if (it != m_tasks.end())
+        {
+            chain = it->second;
+            m_nodes[chain].refCount++;
+        }
+
+        m_running.push_back(RunningTask{ task, chain });
+    }
+
+    void AsyncStackTracker::TaskFinished(const void* task)
+    {
+        // Tasks usually finish innermost first, but a host may report them in any order, so release the most recent
+        // entry for this task wherever it is.
+        for (size_t i = m_running.size(); i > 0; i--)
+        {
+            if (m_running[i - 1].task == task)
+            {
+                uint32_t chain = m_running[i - 1].chain;
+                m_running.erase(m_running.begin() + (i - 1));
+
+                if (chain != kNoChain)
+                {
+                    ReleaseChain(chain);
+                }
+
+                break;
+            }
+        }
+
+        auto it = m_tasks.find(task);
+        if (it != m_tasks.end())
+        {
+            ReleaseChain(it->second);
+            m_tasks.erase(it);
+            m_usedBytes -= kTaskCost;
+        }
+    }
+
+    void AsyncStackTracker::Clear()
+    {
+        m_sites.clear();
+        m_nodes.clear();
+        m_freeNodes.clear();
+        m_tasks.clear();
+        m_usedBytes = 0;
+
+        for (auto& running : m_running)
+        {
+            running.chain = kNoChain;
+        }
+    }
+
+    size_t AsyncStackTracker::UsedBytes() const
+    {
+        return m_usedBytes;
+    }
+
+    size_t AsyncStackTracker::DroppedCount() const
+    {
+        return m_droppedCount;
+    }
+
+    std::unique_ptr<protocol::Runtime::StackTrace> AsyncStackTracker::GetCurrentStackTrace() const
+    {
+        if (m_running.empty() || m_running.back().chain == kNoChain)
+        {
+            return nullptr;
+        }
+
+        std::vector<uint32_t> chain;
+        for (uint32_t id = m_running.back().chain; id != kNoChain && chain.size() < m_maxDepth; id = m_nodes[id].parent)
+        {
+            chain.push_back(id);
+        }
+
+        // Build from the outermost segment in, since each segment owns its parent.
+        std::unique_ptr<protocol::Runtime::StackTrace> result;
+
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            const Site& site = *m_nodes[*it].site;
+
+            auto callFrames = protocol::Array<protocol::Runtime::CallFrame>::create();
+            callFrames->addItem(protocol::Runtime::CallFrame::create()
+                .setFunctionName(String16())
+                .setScriptId(String16())
+                .setUrl(String16::fromUTF8(site.url.c_str(), site.url.length()))
+                .setLineNumber(site.lineNumber > 0 ? site.lineNumber - 1 : 0)
+                .setColumnNumber(site.columnNumber > 0 ? site.columnNumber - 1 : 0)
+                .build());
+
+            std::unique_ptr<protocol::Runtime::StackTrace> segment = protocol::Runtime::StackTrace::create()
+                .setCallFrames(std::move(callFrames))
+                .build();
+
+            if (!site.description.empty())
+            {
+                segment->setDescription(String16::fromUTF8(site.description.c_str(), site.description.length()));
+            }
+
+            if (result)
+            {
+                segment->setParent(std::move(result));
+            }
+
+            result = std::move(segment);
+        }
+
+        return result;
+    }
+
+    const AsyncStackTracker::Site* AsyncStackTracker::AcquireSite(Site site, size_t* cost)
+    {
+        auto it = m_sites.find(site);
+        if (it == m_sites.end())
+        {
+            *cost = SiteCost(site);
+            it = m_sites.emplace(std::move(site), 0).first;
+        }
+
+        it->second++;
+        return &it->first;
+    }
+
+    void AsyncStackTracker::ReleaseSite(const Site* site)
+    {
+        auto it = m_sites.find(*site);
+        if (it == m_sites.end() || --it->second > 0)
+        {
+            return;
+        }
+
+        m_usedBytes -= SiteCost(it->first);
+        m_sites.erase(it);
+    }
+
+    uint32_t AsyncStackTracker::AllocateNode(const Site* site, uint32_t parent)
+    {
+        uint32_t depth = 1;
+        if (parent != kNoChain)
+        {
+            m_nodes[parent].refCount++;
+            depth = m_nodes[parent].depth + 1;
+        }
+
+        ChainNode node = { site, parent, depth, 1 };
+
+        if (!m_freeNodes.empty())
+        {
+            uint32_t id = m_freeNodes.back();
+            m_freeNodes.pop_back();
+            m_nodes[id] = node;
+            return id;
+        }
+
+        m_nodes.push_back(node);
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+    }
+
+    void AsyncStackTracker::ReleaseChain(uint32_t chain)
+    {
+        // Releasing the last reference to a node releases its reference to the parent, and so on up the chain.
+        while (chain != kNoChain)
+        {
+            ChainNode& node = m_nodes[chain];
+            if (--node.refCount > 0)
+            {
+                return;
+            }
+
+            uint32_t parent = node.parent;
+
+            ReleaseSite(node.site);
+            m_freeNodes.push_back(chain);
+            m_usedBytes -= kNodeCost;
+
+            chain = parent;
+        }
+    }
+
+    size_t AsyncStackTracker::SiteCost(const Site& site)
+    {
+        return sizeof(Site) + kSiteOverhead + site.description.length() + site.url.length();
+    }
+
+    size_t AsyncStackTracker::SiteHash::operator()(const Site& site) const
+    {
+        size_t hash = std::hash<std::string>()(site.url);
+        hash = hash * 31 + std::hash<std::string>()(site.description);
+        hash = hash * 31 + std::hash<int>()(site.lineNumber);
+        hash = hash * 31 + std::hash<int>()(site.columnNumber);
+        return hash;
+    }
+}
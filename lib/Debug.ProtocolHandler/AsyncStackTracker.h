@@ -0,0 +1,107 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "protocol\Runtime.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace JsDebug
+{
+    //
+    // Records where asynchronous tasks (promise reactions, timers, ...) were scheduled so that a pause inside a task
+    // can show the chain of scheduling points that led to it.
+    //
+    // Scheduling sites are interned and reference counted, and each task points at a reference counted chain node
+    // whose parent is the chain of the task that was running when it was scheduled. Chains are shared between tasks
+    // and released as a unit when the last task using them finishes. Chains are cut at the maximum depth, and once
+    // the memory budget is used up new tasks are simply not tracked, so the total size never exceeds the budget.
+    //
+    // This is only accessed from the script thread, so it is not synchronized.
+    //
+    class AsyncStackTracker
+    {
+    public:
+        explicit AsyncStackTracker(size_t maxBytes);
+        ~AsyncStackTracker();
+
+        // A depth of 0 disables tracking and releases everything that was recorded.
+        void SetMaxDepth(int maxDepth);
+
+        // The location is 1-based, and 0 if unknown.
+        void TaskScheduled(const void* task, const char* description, const char* url, int lineNumber, int columnNumber);
+        void TaskStarted(const void* task);
+        void TaskFinished(const void* task);
+        void Clear();
+
+        size_t UsedBytes() const;
+        size_t DroppedCount() const;
+
+        // Returns the chain for the task that is currently running, or nullptr if there isn't one.
+        std::unique_ptr<protocol::Runtime::StackTrace> GetCurrentStackTrace() const;
+
+    private:
+        static const uint32_t kNoChain = UINT32_MAX;
+
+        struct Site
+        {
+            std::string description;
+            std::string url;
+            int lineNumber;
+            int columnNumber;
+
+            bool operator==(const Site& other) const
+            {
+                return lineNumber == other.lineNumber &&
+                    columnNumber == other.columnNumber &&
+                    url == other.url &&
+                    description == other.description;
+            }
+        };
+
+        struct SiteHash
+        {
+            size_t operator()(const Site& site) const;
+        };
+
+        struct ChainNode
+        {
+            // Points at the key in m_sites, which stays put for as long as the entry exists.
+            const Site* site;
+            uint32_t parent;
+            uint32_t depth;
+            uint32_t refCount;
+        };
+
+        struct RunningTask
+        {
+            const void* task;
+            uint32_t chain;
+        };
+
+        const Site* AcquireSite(Site site, size_t* cost);
+        void ReleaseSite(const Site* site);
+        uint32_t AllocateNode(const Site* site, uint32_t parent);
+        void ReleaseChain(uint32_t chain);
+
+        static size_t SiteCost(const Site& site);
+
+        size_t m_maxBytes;
+        uint32_t m_maxDepth;
+        size_t m_usedBytes;
+        size_t m_droppedCount;
+
+        std::unordered_map<Site, uint32_t, SiteHash> m_sites;
+        std::vector<ChainNode> m_nodes;
+        std::vector<uint32_t> m_freeNodes;
+        std::unordered_map<const void*, uint32_t> m_tasks;
+        std::vector<RunningTask> m_running;
+    };
+}
@@ -0,0 +1,154 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "BlackboxIndex.h"
+
+#include <algorithm>
+
+namespace JsDebug
+{
+    BlackboxIndex::BlackboxIndex()
+        : m_blackboxedCount(0)
+    {
+    }
+
+    BlackboxIndex::~BlackboxIndex()
+    {
+    }
+
+    void BlackboxIndex::SetPatterns(const std::vector<std::string>& patterns)
+    {
+        std::vector<std::regex> compiled;
+        compiled.reserve(patterns.size());
+
+        for (const auto& pattern : patterns)
+        {
+            compiled.emplace_back(pattern, std::regex::ECMAScript | std::regex::optimize);
+        }
+
+        m_patterns = std::move(compiled);
+        m_blackboxedCount = 0;
+
+        for (auto& script : m_scripts)
+        {
+            ScriptEntry& entry = script.second;
+            entry.matchesPattern = MatchesPattern(entry.url);
+
+            if (entry.matchesPattern || !entry.ranges.empty())
+            {
+                m_blackboxedCount++;
+            }
+        }
+    }
+
+    bool BlackboxIndex::SetRanges(int scriptId, std::vector<Position> positions)
+    {
+        auto unordered = std::adjacent_find(positions.begin(), positions.end(),
+            [](const Position& a, const Position& b) { return !(a < b); });
+
+        if (unordered != positions.end())
+        {
+            return false;
+        }
+
+        ScriptEntry& entry = m_scripts[scriptId];
+        bool wasBlackboxed = entry.matchesPattern || !entry.ranges.empty();
+
+        entry.ranges = std::move(positions);
+
+        bool isBlackboxed = entry.matchesPattern || !entry.ranges.empty();
+        if (isBlackboxed && !wasBlackboxed)
+        {
+            m_blackboxedCount++;
+        }
+        else if (!isBlackboxed && wasBlackboxed)
+        {
+            m_blackboxedCount--;
+        }
+
+        return true;
+    }
+
+    void BlackboxIndex::AddScript(int scriptId, const std::string& url)
+    {
+        ScriptEntry& entry = m_scripts[scriptId];
+        bool wasBlackboxed = entry.matchesPattern || !entry.ranges.empty();
+
+        entry.url = url;
+        entry.matchesPattern = MatchesPattern(url);
+
+        bool isBlackboxed = entry.matchesPattern || !entry.ranges.empty();
+        if (isBlackboxed && !wasBlackboxed)
+        {
+            m_blackboxedCount++;
+        }
+        else if (!isBlackboxed && wasBlackboxed)
+        {
+            m_blackboxedCount--;
+        }
+    }
+
+    void BlackboxIndex::Clear()
+    {
+        m_patterns.clear();
+        m_blackboxedCount = 0;
+
+        for (auto& script : m_scripts)
+        {
+            script.second.matchesPattern = false;
+            script.second.ranges.clear();
+        }
+    }
+
+    bool BlackboxIndex::IsEmpty() const
+    {
+        return m_blackboxedCount == 0;
+    }
+
+    bool BlackboxIndex::IsBlackboxed(int scriptId, int lineNumber, int columnNumber) const
+    {
+        if (m_blackboxedCount == 0)
+        {
+            return false;
+        }
+
+        auto it = m_scripts.find(scriptId);
+        if (it == m_scripts.end())
+        {
+            return false;
+        }
+
+        const ScriptEntry& entry = it->second;
+        if (entry.matchesPattern)
+        {
+            return true;
+        }
+
+        // Each boundary at or before the location toggles the state, and the script starts out not blackboxed.
+        Position position{ lineNumber, columnNumber };
+        auto boundary = std::upper_bound(entry.ranges.begin(), entry.ranges.end(), position);
+
+        return (boundary - entry.ranges.begin()) % 2 == 1;
+    }
+
+    bool BlackboxIndex::MatchesPattern(const std::string& url) const
+    {
+        if (url.empty())
+        {
+            return false;
+        }
+
+        for (const auto& pattern : m_patterns)
+        {
+            if (std::regex_search(url, pattern))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
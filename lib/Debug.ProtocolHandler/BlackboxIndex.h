@@ -0,0 +1,67 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace JsDebug
+{
+    //
+    // Tracks which parts of which scripts are blackboxed. URL patterns are compiled once and matched against each
+    // script when it is parsed (or when the patterns change), and the ranges reported for a script are kept as a
+    // sorted array of boundaries, so checking a location is a hash lookup plus a binary search.
+    //
+    class BlackboxIndex
+    {
+    public:
+        struct Position
+        {
+            int lineNumber;
+            int columnNumber;
+
+            bool operator<(const Position& other) const
+            {
+                return lineNumber < other.lineNumber ||
+                    (lineNumber == other.lineNumber && columnNumber < other.columnNumber);
+            }
+        };
+
+        BlackboxIndex();
+        ~BlackboxIndex();
+
+        // Throws std::regex_error if one of the patterns isn't a valid regular expression.
+        void SetPatterns(const std::vector<std::string>& patterns);
+
+        // Positions where the blackbox state changes, starting out not blackboxed. Returns false if they aren't
+        // strictly increasing.
+        bool SetRanges(int scriptId, std::vector<Position> positions);
+
+        void AddScript(int scriptId, const std::string& url);
+        void Clear();
+
+        bool IsEmpty() const;
+        bool IsBlackboxed(int scriptId, int lineNumber, int columnNumber) const;
+
+    private:
+        struct ScriptEntry
+        {
+            std::string url;
+            bool matchesPattern;
+            std::vector<Position> ranges;
+        };
+
+        bool MatchesPattern(const std::string& url) const;
+
+        std::vector<std::regex> m_patterns;
+        std::unordered_map<int, ScriptEntry> m_scripts;
+
+        // Number of scripts with a pattern match or any ranges, so the common case can bail out early.
+        size_t m_blackboxedCount;
+    };
+}
@@ -37,6 +37,40 @@ CHAKRA_API JsDebugProtocolHandlerConnect(
     return JsNoError;
 }
 
+CHAKRA_API JsDebugProtocolHandlerSetFlushCallback(
+    JsDebugProtocolHandler protocolHandler,
+    JsDebugProtocolHandlerFlushCallback callback)
+{
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    handler->SetFlushCallback(callback);
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugProtocolHandlerSetFragmentCallback(
+    JsDebugProtocolHandler protocolHandler,
+    JsDebugProtocolHandlerSendFragmentCallback callback,
+    size_t fragmentSize)
+{
+    if (fragmentSize == 0)
+    {
+        return JsErrorInvalidArgument;
+    }
+
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    handler->SetFragmentCallback(callback, fragmentSize);
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugProtocolHandlerAllowSourceMapFiles(JsDebugProtocolHandler protocolHandler, size_t maxFileSize)
+{
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    handler->SetMaxSourceMapFileSize(maxFileSize);
+
+    return JsNoError;
+}
+
 CHAKRA_API JsDebugProtocolHandlerDisconnect(JsDebugProtocolHandler protocolHandler)
 {
     auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
@@ -53,6 +87,22 @@ CHAKRA_API JsDebugProtocolHandlerSendCommand(JsDebugProtocolHandler protocolHand
     return JsNoError;
 }
 
+CHAKRA_API JsDebugProtocolHandlerSendCborCommand(
+    JsDebugProtocolHandler protocolHandler,
+    const uint8_t* command,
+    size_t length)
+{
+    if (command == nullptr)
+    {
+        return JsErrorNullArgument;
+    }
+
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    handler->SendCborCommand(command, length);
+
+    return JsNoError;
+}
+
 CHAKRA_API JsDebugProtocolHandlerWaitForDebugger(JsDebugProtocolHandler protocolHandler)
 {
     auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
@@ -60,3 +110,93 @@ CHAKRA_API JsDebugProtocolHandlerWaitForDebugger(JsDebugProtocolHandler protocol
 
     return JsNoError;
 }
+
+CHAKRA_API JsDebugProtocolHandlerAddEventListener(
+    JsDebugProtocolHandler protocolHandler,
+    unsigned int eventTypes,
+    JsDebugEventCallback callback,
+    void* callbackState,
+    JsDebugEventListener* listener)
+{
+    if (callback == nullptr || listener == nullptr)
+    {
+        return JsErrorNullArgument;
+    }
+
+    if (eventTypes == 0 || (eventTypes & ~JsDebugEventTypeAll) != 0)
+    {
+        return JsErrorInvalidArgument;
+    }
+
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    *listener = handler->AddEventListener(eventTypes, callback, callbackState);
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugProtocolHandlerRemoveEventListener(
+    JsDebugProtocolHandler protocolHandler,
+    JsDebugEventListener listener)
+{
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    if (!handler->RemoveEventListener(listener))
+    {
+        return JsErrorInvalidArgument;
+    }
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugProtocolHandlerConsoleAPICalled(
+    JsDebugProtocolHandler protocolHandler,
+    JsDebugConsoleAPIType type,
+    const char* text,
+    const char* url,
+    int lineNumber,
+    int columnNumber)
+{
+    if (text == nullptr)
+    {
+        return JsErrorNullArgument;
+    }
+
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    handler->ConsoleAPICalled(type, text, url, lineNumber, columnNumber);
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugProtocolHandlerAsyncTaskScheduled(
+    JsDebugProtocolHandler protocolHandler,
+    void* task,
+    const char* description,
+    const char* url,
+    int lineNumber,
+    int columnNumber)
+{
+    if (task == nullptr)
+    {
+        return JsErrorNullArgument;
+    }
+
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    handler->AsyncTaskScheduled(task, description, url, lineNumber, columnNumber);
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugProtocolHandlerAsyncTaskStarted(JsDebugProtocolHandler protocolHandler, void* task)
+{
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    handler->AsyncTaskStarted(task);
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugProtocolHandlerAsyncTaskFinished(JsDebugProtocolHandler protocolHandler, void* task)
+{
+    auto handler = reinterpret_cast<JsDebug::ProtocolHandler*>(protocolHandler);
+    handler->AsyncTaskFinished(task);
+
+    return JsNoError;
+}
@@ -9,6 +9,125 @@
 
 typedef struct JsDebugProtocolHandler__* JsDebugProtocolHandler;
 typedef void(CHAKRA_CALLBACK* JsDebugProtocolHandlerSendResponseCallback)(const char* response, void* callbackState);
+typedef void(CHAKRA_CALLBACK* JsDebugProtocolHandlerFlushCallback)(void* callbackState);
+typedef void(CHAKRA_CALLBACK* JsDebugProtocolHandlerSendFragmentCallback)(
+    const char* fragment,
+    size_t length,
+    bool final,
+    void* callbackState);
+
+/// <summary>The kind of console API call being reported.</summary>
+typedef enum _JsDebugConsoleAPIType
+{
+    JsDebugConsoleAPITypeLog = 0,
+    JsDebugConsoleAPITypeDebug = 1,
+    JsDebugConsoleAPITypeInfo = 2,
+    JsDebugConsoleAPITypeError = 3,
+    JsDebugConsoleAPITypeWarning = 4,
+} JsDebugConsoleAPIType;
+
+typedef struct JsDebugEventListener__* JsDebugEventListener;
+
+/// <summary>The kinds of event delivered to native event listeners, which can be combined into a mask.</summary>
+typedef enum _JsDebugEventType
+{
+    JsDebugEventTypeScriptParsed = 0x1,
+    JsDebugEventTypePaused = 0x2,
+    JsDebugEventTypeResumed = 0x4,
+    JsDebugEventTypeConsoleMessage = 0x8,
+    JsDebugEventTypeException = 0x10,
+    JsDebugEventTypeAll = 0x1f,
+} JsDebugEventType;
+
+/// <summary>Why the engine paused.</summary>
+typedef enum _JsDebugPauseReason
+{
+    JsDebugPauseReasonOther = 0,
+    JsDebugPauseReasonException = 1,
+} JsDebugPauseReason;
+
+/// <summary>A UTF-8 encoded string that is only valid for the duration of the callback it was passed to.</summary>
+/// <remarks>The string is not null-terminated. An absent string has a length of zero.</remarks>
+typedef struct _JsDebugStringView
+{
+    const char* data;
+    size_t length;
+} JsDebugStringView;
+
+typedef struct _JsDebugScriptParsedEvent
+{
+    int scriptId;
+    JsDebugStringView url;
+    int endLine;
+    int endColumn;
+
+    /// <summary>Only set when the script's source map couldn't be loaded by the protocol handler.</summary>
+    JsDebugStringView sourceMapUrl;
+
+    /// <summary>For an original source from a source map, the id of the generated script; otherwise -1.</summary>
+    int generatedScriptId;
+} JsDebugScriptParsedEvent;
+
+typedef struct _JsDebugCallFrame
+{
+    int scriptId;
+    /// <summary>The 0-based line and column, in terms of the original source if the script has a source map.</summary>
+    int line;
+    int column;
+    JsDebugStringView functionName;
+} JsDebugCallFrame;
+
+typedef struct _JsDebugPausedEvent
+{
+    JsDebugPauseReason reason;
+
+    /// <summary>The breakpoint that was hit, or -1 if there wasn't one.</summary>
+    int breakpointId;
+
+    /// <summary>The call stack, innermost frame first.</summary>
+    const JsDebugCallFrame* callFrames;
+    size_t callFrameCount;
+} JsDebugPausedEvent;
+
+typedef struct _JsDebugConsoleMessageEvent
+{
+    JsDebugConsoleAPIType type;
+    JsDebugStringView text;
+    JsDebugStringView url;
+    /// <summary>The 1-based line and column as reported by the caller, or 0 if unknown.</summary>
+    int lineNumber;
+    int columnNumber;
+    /// <summary>Milliseconds since the Unix epoch.</summary>
+    double timestamp;
+} JsDebugConsoleMessageEvent;
+
+typedef struct _JsDebugExceptionEvent
+{
+    bool uncaught;
+    /// <summary>The exception as it would be displayed, e.g. "TypeError: x is undefined".</summary>
+    JsDebugStringView text;
+    int scriptId;
+    /// <summary>The 0-based line and column where the exception was thrown.</summary>
+    int line;
+    int column;
+    /// <summary>Milliseconds since the Unix epoch.</summary>
+    double timestamp;
+} JsDebugExceptionEvent;
+
+/// <summary>An event delivered to a native event listener. The member of data to read depends on the type.</summary>
+typedef struct _JsDebugEvent
+{
+    JsDebugEventType type;
+    union
+    {
+        JsDebugScriptParsedEvent scriptParsed;
+        JsDebugPausedEvent paused;
+        JsDebugConsoleMessageEvent consoleMessage;
+        JsDebugExceptionEvent exception;
+    } data;
+} JsDebugEvent;
+
+typedef void(CHAKRA_CALLBACK* JsDebugEventCallback)(const JsDebugEvent* event, void* callbackState);
 
 /// <summary>Creates a <seealso cref="JsDebugProtocolHandler" /> instance for a given runtime.</summary>
 /// <remarks>
@@ -44,6 +163,48 @@ CHAKRA_API JsDebugProtocolHandlerConnect(
     JsDebugProtocolHandlerSendResponseCallback callback,
     void* callbackState);
 
+/// <summary>Set a callback that marks the end of a batch of responses.</summary>
+/// <remarks>
+///     Once set, the response callback's receiver may hold on to responses until the flush callback is invoked, which
+///     happens after every command and event. Bursts of events, such as scripts reported when the debugger is
+///     enabled, are followed by a single flush. The callback gets the state object passed to
+///     <c>JsDebugProtocolHandlerConnect</c> and is cleared on disconnect.
+/// </remarks>
+/// <param name="protocolHandler">The connected instance.</param>
+/// <param name="callback">The flush callback function pointer.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerSetFlushCallback(
+    JsDebugProtocolHandler protocolHandler,
+    JsDebugProtocolHandlerFlushCallback callback);
+
+/// <summary>Set a callback that receives large responses a fragment at a time.</summary>
+/// <remarks>
+///     Responses longer than the fragment size are passed to this callback in consecutive fragments of at most that
+///     many bytes instead of to the response callback, without ever being held in memory in one piece. The last
+///     fragment of each response is marked as final. The callback gets the state object passed to
+///     <c>JsDebugProtocolHandlerConnect</c> and is cleared on disconnect.
+/// </remarks>
+/// <param name="protocolHandler">The connected instance.</param>
+/// <param name="callback">The fragment callback function pointer.</param>
+/// <param name="fragmentSize">The largest fragment to pass to the callback, which must not be zero.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerSetFragmentCallback(
+    JsDebugProtocolHandler protocolHandler,
+    JsDebugProtocolHandlerSendFragmentCallback callback,
+    size_t fragmentSize);
+
+/// <summary>Allow source maps to be read from the local file system.</summary>
+/// <remarks>
+///     By default only maps embedded in <c>data:</c> URLs are decoded, and any other map is left for the frontend to
+///     fetch. Once allowed, maps referenced by path or <c>file://</c> URL are read directly if they are regular
+///     files no larger than the given size; network shares and device paths are never read. This must be called
+///     from the script thread, and only applies to scripts loaded afterwards.
+/// </remarks>
+/// <param name="protocolHandler">The protocol handler instance.</param>
+/// <param name="maxFileSize">The largest map file to read, in bytes, or zero to stop reading files again.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerAllowSourceMapFiles(JsDebugProtocolHandler protocolHandler, size_t maxFileSize);
+
 /// <summary>Disconnect from the protocol handler and clear any breakpoints.</summary>
 /// <param name="protocolHandler">The instance to disconnect from.</param>
 /// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
@@ -58,6 +219,20 @@ CHAKRA_API JsDebugProtocolHandlerDisconnect(JsDebugProtocolHandler protocolHandl
 /// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
 CHAKRA_API JsDebugProtocolHandlerSendCommand(JsDebugProtocolHandler protocolHandler, const char* command);
 
+/// <summary>Send an incoming CBOR-encoded command to the protocol handler.</summary>
+/// <remarks>
+///     The command is dispatched without going through JSON. Responses and events are still JSON-formatted; hosts
+///     that want them binary transcode them as they're sent.
+/// </remarks>
+/// <param name="protocolHandler">The receiving protocol handler.</param>
+/// <param name="command">The CBOR-encoded command to send.</param>
+/// <param name="length">The length of the command in bytes.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerSendCborCommand(
+    JsDebugProtocolHandler protocolHandler,
+    const uint8_t* command,
+    size_t length);
+
 /// <summary>Blocks the current thread until the debugger has connected.</summary>
 /// <remarks>
 ///     This must be called from the script thread.
@@ -65,3 +240,97 @@ CHAKRA_API JsDebugProtocolHandlerSendCommand(JsDebugProtocolHandler protocolHand
 /// <param name="protocolHandler">The instance to wait on.</param>
 /// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
 CHAKRA_API JsDebugProtocolHandlerWaitForDebugger(JsDebugProtocolHandler protocolHandler);
+
+/// <summary>Add a listener that receives debug events as structures instead of JSON-formatted messages.</summary>
+/// <remarks>
+///     Listeners work with or without a connected debugger and see events as they happen; nothing from before a
+///     listener was added is replayed to it. Events are delivered on the script thread, and a paused event is
+///     delivered while the engine is paused. Anything an event points to is only valid until the callback returns.
+///     Listeners may be added and removed from any thread, including from a callback.
+/// </remarks>
+/// <param name="protocolHandler">The instance to listen to.</param>
+/// <param name="eventTypes">The <c>JsDebugEventType</c> values of the events to deliver, combined.</param>
+/// <param name="callback">The event callback function pointer.</param>
+/// <param name="callbackState">The state object to return on each invocation of the callback.</param>
+/// <param name="listener">The newly added listener.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerAddEventListener(
+    JsDebugProtocolHandler protocolHandler,
+    unsigned int eventTypes,
+    JsDebugEventCallback callback,
+    void* callbackState,
+    JsDebugEventListener* listener);
+
+/// <summary>Remove a listener added with <c>JsDebugProtocolHandlerAddEventListener</c>.</summary>
+/// <remarks>
+///     If an event is being delivered on another thread, this waits for it to finish, so the callback isn't running
+///     or invoked again once this returns. Called from within a callback, it returns right away, and the event being
+///     delivered may still reach the removed listener.
+/// </remarks>
+/// <param name="protocolHandler">The instance the listener was added to.</param>
+/// <param name="listener">The listener to remove.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerRemoveEventListener(
+    JsDebugProtocolHandler protocolHandler,
+    JsDebugEventListener listener);
+
+/// <summary>Report a console API call (e.g. <c>console.log</c>) made by script.</summary>
+/// <remarks>
+///     Messages are retained in a bounded buffer whether or not a debugger is connected, and are replayed when the
+///     frontend enables the Console or Runtime domain. The oldest messages are discarded once the buffer is full.
+///     This must be called from the script thread.
+/// </remarks>
+/// <param name="protocolHandler">The receiving protocol handler.</param>
+/// <param name="type">The type of console call.</param>
+/// <param name="text">The UTF-8 encoded message text.</param>
+/// <param name="url">The UTF-8 encoded URL of the calling script, or nullptr if unknown.</param>
+/// <param name="lineNumber">The (1-based) line number of the call, or 0 if unknown.</param>
+/// <param name="columnNumber">The (1-based) column number of the call, or 0 if unknown.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerConsoleAPICalled(
+    JsDebugProtocolHandler protocolHandler,
+    JsDebugConsoleAPIType type,
+    const char* text,
+    const char* url,
+    int lineNumber,
+    int columnNumber);
+
+/// <summary>Report that script scheduled an asynchronous task (e.g. a promise reaction or a timer callback).</summary>
+/// <remarks>
+///     Together with <c>JsDebugProtocolHandlerAsyncTaskStarted</c> and <c>JsDebugProtocolHandlerAsyncTaskFinished</c>
+///     this lets a debugger paused inside the task show where it was scheduled from. Nothing is recorded unless the
+///     frontend has set a non-zero async call stack depth, and tracking stops at a fixed memory limit.
+///     This must be called from the script thread.
+/// </remarks>
+/// <param name="protocolHandler">The receiving protocol handler.</param>
+/// <param name="task">An identifier for the task, unique until the task is finished.</param>
+/// <param name="description">The UTF-8 encoded description of the scheduling call (e.g. "setTimeout").</param>
+/// <param name="url">The UTF-8 encoded URL of the scheduling script, or nullptr if unknown.</param>
+/// <param name="lineNumber">The (1-based) line number of the scheduling call, or 0 if unknown.</param>
+/// <param name="columnNumber">The (1-based) column number of the scheduling call, or 0 if unknown.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerAsyncTaskScheduled(
+    JsDebugProtocolHandler protocolHandler,
+    void* task,
+    const char* description,
+    const char* url,
+    int lineNumber,
+    int columnNumber);
+
+/// <summary>Report that a previously scheduled asynchronous task has started running.</summary>
+/// <remarks>
+///     This must be called from the script thread.
+/// </remarks>
+/// <param name="protocolHandler">The receiving protocol handler.</param>
+/// <param name="task">The identifier passed to <c>JsDebugProtocolHandlerAsyncTaskScheduled</c>.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerAsyncTaskStarted(JsDebugProtocolHandler protocolHandler, void* task);
+
+/// <summary>Report that an asynchronous task has finished running, or was canceled before it ran.</summary>
+/// <remarks>
+///     This must be called from the script thread.
+/// </remarks>
+/// <param name="protocolHandler">The receiving protocol handler.</param>
+/// <param name="task">The identifier passed to <c>JsDebugProtocolHandlerAsyncTaskScheduled</c>.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugProtocolHandlerAsyncTaskFinished(JsDebugProtocolHandler protocolHandler, void* task);
@@ -6,10 +6,13 @@
 #include "stdafx.h"
 #include "ConsoleImpl.h"
 
+#include "ProtocolHandler.h"
+
 namespace JsDebug
 {
     ConsoleImpl::ConsoleImpl(ProtocolHandler* handler)
         : m_handler(handler)
+        , m_enabled(false)
     {
     }
 
@@ -17,18 +20,33 @@ namespace JsDebug
     {
     }
 
+    bool ConsoleImpl::IsEnabled() const
+    {
+        return m_enabled;
+    }
+
     Response ConsoleImpl::enable()
     {
-        return Response();
+        if (m_enabled)
+        {
+            return Response::OK();
+        }
+
+        m_enabled = true;
+        m_handler->ReplayConsoleMessages(ConsoleMessageKind::MessageAdded);
+
+        return Response::OK();
     }
 
     Response ConsoleImpl::disable()
     {
-        return Response();
+        m_enabled = false;
+        return Response::OK();
     }
 
     Response ConsoleImpl::clearMessages()
     {
-        return Response();
+        m_handler->ClearConsoleMessages();
+        return Response::OK();
     }
 }
\ No newline at end of file
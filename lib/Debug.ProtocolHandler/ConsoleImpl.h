@@ -20,6 +20,8 @@ namespace JsDebug
         ConsoleImpl(ProtocolHandler* handler);
         ~ConsoleImpl() override;
 
+        bool IsEnabled() const;
+
         // protocol::Console::Backend implementation
         Response enable() override;
         Response disable() override;
@@ -27,5 +29,6 @@ namespace JsDebug
 
     private:
         ProtocolHandler* m_handler;
+        bool m_enabled;
     };
 }
@@ -0,0 +1,169 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "ConsoleMessageBuffer.h"
+
+#include <cstring>
+
+namespace JsDebug
+{
+    ConsoleMessageBuffer::ConsoleMessageBuffer(size_t maxEntries, size_t maxBytes)
+        : m_maxEntries(maxEntries)
+        , m_maxBytes(maxBytes)
+        , m_head(0)
+        , m_count(0)
+        , m_writeOffset(0)
+        , m_droppedCount(0)
+    {
+    }
+
+    ConsoleMessageBuffer::~ConsoleMessageBuffer()
+    {
+    }
+
+    void ConsoleMessageBuffer::Add(const JsDebugConsoleMessageEvent& message)
+    {
+        // Both strings are stored null-terminated, which also keeps every entry at least a byte long.
+        size_t urlOffset = message.text.length + 1;
+        size_t size = urlOffset + message.url.length + 1;
+
+        if (m_maxEntries == 0 || size > m_maxBytes)
+        {
+            m_droppedCount++;
+            return;
+        }
+
+        // The storage is only committed once something is actually logged.
+        if (m_data.empty())
+        {
+            m_data.resize(m_maxBytes);
+            m_entries.resize(m_maxEntries);
+        }
+
+        if (m_count == m_maxEntries)
+        {
+            EvictOldest();
+        }
+
+        size_t offset = 0;
+        while (!TryReserve(size, &offset))
+        {
+            EvictOldest();
+        }
+
+        char* data = &m_data[offset];
+        if (message.text.length != 0)
+        {
+            std::memcpy(data, message.text.data, message.text.length);
+        }
+
+        if (message.url.length != 0)
+        {
+            std::memcpy(data + urlOffset, message.url.data, message.url.length);
+        }
+
+        data[urlOffset - 1] = '\0';
+        data[size - 1] = '\0';
+        m_writeOffset = offset + size;
+
+        Entry& entry = m_entries[(m_head + m_count) % m_maxEntries];
+        entry.offset = static_cast<uint32_t>(offset);
+        entry.textLength = static_cast<uint32_t>(message.text.length);
+        entry.urlLength = static_cast<uint32_t>(message.url.length);
+        entry.type = message.type;
+        entry.lineNumber = message.lineNumber;
+        entry.columnNumber = message.columnNumber;
+        entry.timestamp = message.timestamp;
+        m_count++;
+    }
+
+    void ConsoleMessageBuffer::Clear()
+    {
+        m_head = 0;
+        m_count = 0;
+        m_writeOffset = 0;
+    }
+
+    size_t ConsoleMessageBuffer::Count() const
+    {
+        return m_count;
+    }
+
+    size_t ConsoleMessageBuffer::DroppedCount() const
+    {
+        return m_droppedCount;
+    }
+
+    bool ConsoleMessageBuffer::GetEntry(size_t index, JsDebugConsoleMessageEvent* message) const
+    {
+        if (index >= m_count)
+        {
+            return false;
+        }
+
+        const Entry& entry = m_entries[(m_head + index) % m_maxEntries];
+        const char* data = m_data.data() + entry.offset;
+
+        message->type = entry.type;
+        message->text = JsDebugStringView{ data, entry.textLength };
+        message->url = JsDebugStringView{ data + entry.textLength + 1, entry.urlLength };
+        message->lineNumber = entry.lineNumber;
+        message->columnNumber = entry.columnNumber;
+        message->timestamp = entry.timestamp;
+        return true;
+    }
+
+    bool ConsoleMessageBuffer::TryReserve(size_t size, size_t* offset) const
+    {
+        if (m_count == 0)
+        {
+            *offset = 0;
+            return true;
+        }
+
+        size_t oldest = m_entries[m_head].offset;
+
+        if (m_writeOffset > oldest)
+        {
+            // Live data is [oldest, write), so there is space at the end and, after wrapping, before the oldest entry.
+            if (m_maxBytes - m_writeOffset >= size)
+            {
+                *offset = m_writeOffset;
+                return true;
+            }
+
+            if (oldest >= size)
+            {
+                *offset = 0;
+                return true;
+            }
+
+            return false;
+        }
+
+        // Live data has wrapped around, so the only free space is [write, oldest).
+        if (oldest - m_writeOffset >= size)
+        {
+            *offset = m_writeOffset;
+            return true;
+        }
+
+        return false;
+    }
+
+    void ConsoleMessageBuffer::EvictOldest()
+    {
+        m_head = (m_head + 1) % m_maxEntries;
+        m_count--;
+        m_droppedCount++;
+
+        if (m_count == 0)
+        {
+            m_head = 0;
+            m_writeOffset = 0;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ChakraDebugProtocolHandler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace JsDebug
+{
+    // The protocol notifications a console message is sent as.
+    enum class ConsoleMessageKind : uint8_t
+    {
+        MessageAdded,
+        ConsoleAPICalled,
+    };
+
+    //
+    // Fixed-capacity ring of console messages, kept as the fields the notifications are built from rather than in
+    // serialized form, so that a message costs nothing to serialize until a frontend asks for it. The text and URL of
+    // each message are stored back-to-back in a single byte ring so that neither the entry count nor the memory used
+    // can grow past the limits given at construction, regardless of how many messages are added. The oldest entries
+    // are evicted to make room.
+    //
+    // This is only accessed from the script thread, so it is not synchronized.
+    //
+    class ConsoleMessageBuffer
+    {
+    public:
+        ConsoleMessageBuffer(size_t maxEntries, size_t maxBytes);
+        ~ConsoleMessageBuffer();
+
+        void Add(const JsDebugConsoleMessageEvent& message);
+        void Clear();
+
+        size_t Count() const;
+        size_t DroppedCount() const;
+
+        // Index 0 is the oldest retained entry. The strings in the returned message are valid until the next call to
+        // Add or Clear.
+        bool GetEntry(size_t index, JsDebugConsoleMessageEvent* message) const;
+
+    private:
+        struct Entry
+        {
+            uint32_t offset;
+            uint32_t textLength;
+            uint32_t urlLength;
+            JsDebugConsoleAPIType type;
+            int lineNumber;
+            int columnNumber;
+            double timestamp;
+        };
+
+        bool TryReserve(size_t size, size_t* offset) const;
+        void EvictOldest();
+
+        size_t m_maxEntries;
+        size_t m_maxBytes;
+
+        std::vector<Entry> m_entries;
+        std::vector<char> m_data;
+        size_t m_head;
+        size_t m_count;
+        size_t m_writeOffset;
+        size_t m_droppedCount;
+    };
+}
@@ -0,0 +1,157 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "ConsoleMessageThrottle.h"
+
+#include <algorithm>
+
+namespace JsDebug
+{
+    ConsoleMessageThrottle::ConsoleMessageThrottle(
+        double messagesPerSecond,
+        double burstSize,
+        size_t maxCallSites,
+        std::chrono::milliseconds repeatReportInterval)
+        : m_messagesPerSecond(messagesPerSecond)
+        , m_burstSize(burstSize)
+        , m_maxCallSites(maxCallSites)
+        , m_repeatReportInterval(repeatReportInterval)
+        , m_hasLastMessage(false)
+        , m_repeatCount(0)
+    {
+    }
+
+    ConsoleMessageThrottle::~ConsoleMessageThrottle()
+    {
+    }
+
+    bool ConsoleMessageThrottle::IsRepeat(
+        JsDebugConsoleAPIType type,
+        const char* text,
+        const char* url,
+        int lineNumber,
+        int columnNumber)
+    {
+        if (!m_hasLastMessage ||
+            m_lastMessage.type != type ||
+            m_lastMessage.lineNumber != lineNumber ||
+            m_lastMessage.columnNumber != columnNumber ||
+            m_lastMessage.url.compare(url != nullptr ? url : "") != 0 ||
+            m_lastMessage.text.compare(text) != 0)
+        {
+            return false;
+        }
+
+        if (m_repeatCount++ == 0)
+        {
+            m_firstRepeat = clock::now();
+        }
+
+        return true;
+    }
+
+    uint32_t ConsoleMessageThrottle::TakeRepeatCount()
+    {
+        uint32_t count = m_repeatCount;
+        m_repeatCount = 0;
+        return count;
+    }
+
+    bool ConsoleMessageThrottle::IsRepeatReportDue() const
+    {
+        return m_repeatCount != 0 && clock::now() - m_firstRepeat >= m_repeatReportInterval;
+    }
+
+    bool ConsoleMessageThrottle::TryAcquire(const char* url, int lineNumber, int columnNumber, uint32_t* suppressedCount)
+    {
+        clock::time_point now = clock::now();
+        uint64_t key = HashCallSite(url, lineNumber, columnNumber);
+
+        auto it = m_buckets.find(key);
+        if (it == m_buckets.end())
+        {
+            // Keep the table bounded; losing the history of every call site only makes the limit briefly lenient.
+            if (m_buckets.size() >= m_maxCallSites)
+            {
+                m_buckets.clear();
+            }
+
+            it = m_buckets.emplace(key, Bucket{ m_burstSize, now, 0 }).first;
+        }
+
+        Bucket& bucket = it->second;
+
+        std::chrono::duration<double> elapsed = now - bucket.lastRefill;
+        bucket.tokens = (std::min)(m_burstSize, bucket.tokens + elapsed.count() * m_messagesPerSecond);
+        bucket.lastRefill = now;
+
+        if (bucket.tokens < 1.0)
+        {
+            bucket.suppressedCount++;
+            return false;
+        }
+
+        bucket.tokens -= 1.0;
+        *suppressedCount = bucket.suppressedCount;
+        bucket.suppressedCount = 0;
+        return true;
+    }
+
+    void ConsoleMessageThrottle::SetLastMessage(
+        JsDebugConsoleAPIType type,
+        const char* text,
+        const char* url,
+        int lineNumber,
+        int columnNumber)
+    {
+        m_hasLastMessage = true;
+        m_lastMessage.type = type;
+        m_lastMessage.text.assign(text);
+        m_lastMessage.url.assign(url != nullptr ? url : "");
+        m_lastMessage.lineNumber = lineNumber;
+        m_lastMessage.columnNumber = columnNumber;
+        m_repeatCount = 0;
+    }
+
+    const ConsoleMessageInfo& ConsoleMessageThrottle::GetLastMessage() const
+    {
+        return m_lastMessage;
+    }
+
+    void ConsoleMessageThrottle::ClearLastMessage()
+    {
+        m_hasLastMessage = false;
+        m_repeatCount = 0;
+    }
+
+    uint64_t ConsoleMessageThrottle::HashCallSite(const char* url, int lineNumber, int columnNumber)
+    {
+        // FNV-1a, so that looking up a call site doesn't need to allocate a key.
+        uint64_t hash = 14695981039346656037ull;
+
+        auto mix = [&hash](uint8_t value)
+        {
+            hash ^= value;
+            hash *= 1099511628211ull;
+        };
+
+        if (url != nullptr)
+        {
+            for (const char* p = url; *p != '\0'; p++)
+            {
+                mix(static_cast<uint8_t>(*p));
+            }
+        }
+
+        for (int i = 0; i < 4; i++)
+        {
+            mix(static_cast<uint8_t>(static_cast<uint32_t>(lineNumber) >> (i * 8)));
+            mix(static_cast<uint8_t>(static_cast<uint32_t>(columnNumber) >> (i * 8)));
+        }
+
+        return hash;
+    }
+}
@@ -0,0 +1,91 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ChakraDebugProtocolHandler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace JsDebug
+{
+    struct ConsoleMessageInfo
+    {
+        JsDebugConsoleAPIType type;
+        std::string text;
+        std::string url;
+        int lineNumber;
+        int columnNumber;
+    };
+
+    //
+    // Decides which console messages are worth serializing. Identical consecutive messages from the same location are
+    // collapsed into a repeat count, and each call site gets a token bucket so a single hot loop can't flood the
+    // frontend. All checks happen on the raw message, before anything is serialized.
+    //
+    // This is only accessed from the script thread, so it is not synchronized.
+    //
+    class ConsoleMessageThrottle
+    {
+    public:
+        ConsoleMessageThrottle(
+            double messagesPerSecond,
+            double burstSize,
+            size_t maxCallSites,
+            std::chrono::milliseconds repeatReportInterval);
+        ~ConsoleMessageThrottle();
+
+        // Returns true (and counts the repeat) if the message is identical to the last accepted one.
+        bool IsRepeat(JsDebugConsoleAPIType type, const char* text, const char* url, int lineNumber, int columnNumber);
+
+        // Returns the number of repeats collapsed since the last accepted message (or the last time they were taken)
+        // and resets it.
+        uint32_t TakeRepeatCount();
+
+        // True once repeats have been collapsed for longer than the report interval, so that a long run of them is
+        // reported as it goes rather than only when it ends.
+        bool IsRepeatReportDue() const;
+
+        // Takes a token from the call site's bucket. If this succeeds, suppressedCount receives the number of
+        // messages that were dropped from the same call site since the last one that got through.
+        bool TryAcquire(const char* url, int lineNumber, int columnNumber, uint32_t* suppressedCount);
+
+        void SetLastMessage(
+            JsDebugConsoleAPIType type,
+            const char* text,
+            const char* url,
+            int lineNumber,
+            int columnNumber);
+        const ConsoleMessageInfo& GetLastMessage() const;
+
+        void ClearLastMessage();
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        struct Bucket
+        {
+            double tokens;
+            clock::time_point lastRefill;
+            uint32_t suppressedCount;
+        };
+
+        static uint64_t HashCallSite(const char* url, int lineNumber, int columnNumber);
+
+        double m_messagesPerSecond;
+        double m_burstSize;
+        size_t m_maxCallSites;
+        clock::duration m_repeatReportInterval;
+        std::unordered_map<uint64_t, Bucket> m_buckets;
+
+        bool m_hasLastMessage;
+        ConsoleMessageInfo m_lastMessage;
+        uint32_t m_repeatCount;
+        clock::time_point m_firstRepeat;
+    };
+}
@@ -6,16 +6,85 @@
 #include "stdafx.h"
 #include "Debugger.h"
 
+#include "PropertyHelpers.h"
+
+#include <algorithm>
+
 namespace JsDebug
 {
+    namespace
+    {
+        // Number of consecutive step-ins tried while looking for a way out of blackboxed code before stepping out.
+        const int kMaxBlackboxedStepIns = 100;
+
+        // The sourceMappingURL comment is expected at the end of the script, so only this much of it is searched.
+        const int kSourceMappingUrlSearchLength = 4096;
+
+        const char kSourceMappingUrlPrefix[] = "# sourceMappingURL=";
+        const char kLegacySourceMappingUrlPrefix[] = "@ sourceMappingURL=";
+
+        // Finds the value of the last "//# sourceMappingURL=" comment.
+        std::string ParseSourceMappingUrl(const std::string& text)
+        {
+            size_t position = text.length();
+
+            while (position > 0)
+            {
+                size_t comment = text.rfind("//", position - 1);
+                if (comment == std::string::npos)
+                {
+                    break;
+                }
+
+                position = comment;
+
+                const char* prefix = nullptr;
+                if (text.compare(comment + 2, sizeof(kSourceMappingUrlPrefix) - 1, kSourceMappingUrlPrefix) == 0)
+                {
+                    prefix = kSourceMappingUrlPrefix;
+                }
+                else if (text.compare(
+                    comment + 2,
+                    sizeof(kLegacySourceMappingUrlPrefix) - 1,
+                    kLegacySourceMappingUrlPrefix) == 0)
+                {
+                    prefix = kLegacySourceMappingUrlPrefix;
+                }
+
+                if (prefix == nullptr)
+                {
+                    continue;
+                }
+
+                size_t start = comment + 2 + std::char_traits<char>::length(prefix);
+                size_t end = text.find_first_of(" \t\r\n", start);
+                return text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            }
+
+            return std::string();
+        }
+    }
+
     Debugger::Debugger(JsRuntimeHandle runtime)
         : m_runtime(runtime)
         , m_messageCallback(nullptr)
         , m_messageCallbackState(nullptr)
         , m_debugCallback(nullptr)
         , m_debugCallbackState(nullptr)
+        , m_breakCallback(nullptr)
+        , m_breakCallbackState(nullptr)
+        , m_scriptCallback(nullptr)
+        , m_scriptCallbackState(nullptr)
+        , m_breakpointCallback(nullptr)
+        , m_breakpointCallbackState(nullptr)
         , m_enabled(false)
         , m_pauseOnNextStatement(false)
+        , m_paused(false)
+        , m_nextBreakpointId(1)
+        , m_stepping(false)
+        , m_stepType(JsDiagStepTypeStepIn)
+        , m_blackboxedStepCount(0)
+        , m_oneShotBreakpointId(-1)
     {
         IfJsErrorThrow(JsDiagStartDebugging(m_runtime, &Debugger::DebugEventCallback, this), "failed to start debugging");
     }
@@ -41,7 +110,8 @@ namespace JsDebug
 
         m_enabled = true;
 
-        // TODO: Other initialization
+        // Scripts parsed before the debugger was enabled didn't raise source events.
+        LoadScripts();
     }
 
     void Debugger::Disable()
@@ -52,6 +122,8 @@ namespace JsDebug
         }
 
         m_enabled = false;
+        m_stepping = false;
+        RemoveOneShotBreakpoint();
         ClearBreakpoints();
     }
 
@@ -72,6 +144,268 @@ namespace JsDebug
         m_debugCallbackState = callbackState;
     }
 
+    void Debugger::SetBreakHandler(DebuggerBreakHandler callback, void* callbackState)
+    {
+        m_breakCallback = callback;
+        m_breakCallbackState = callbackState;
+    }
+
+    void Debugger::SetScriptHandler(DebuggerScriptHandler callback, void* callbackState)
+    {
+        m_scriptCallback = callback;
+        m_scriptCallbackState = callbackState;
+    }
+
+    void Debugger::SetBreakpointHandler(DebuggerBreakpointHandler callback, void* callbackState)
+    {
+        m_breakpointCallback = callback;
+        m_breakpointCallbackState = callbackState;
+    }
+
+    const ScriptRegistry& Debugger::Scripts() const
+    {
+        return m_scripts;
+    }
+
+    void Debugger::SetMaxSourceMapFileSize(size_t maxFileSize)
+    {
+        m_scripts.SetMaxSourceMapFileSize(maxFileSize);
+    }
+
+    bool Debugger::GetScriptSource(int scriptId, std::string* source)
+    {
+        const ScriptInfo* script = m_scripts.Find(scriptId);
+        if (script == nullptr)
+        {
+            return false;
+        }
+
+        if (script->generatedScriptId != -1)
+        {
+            const std::string* content = nullptr;
+            if (!m_scripts.TryGetSourceContent(scriptId, &content))
+            {
+                return false;
+            }
+
+            *source = *content;
+            return true;
+        }
+
+        JsValueRef sourceInfo = JS_INVALID_REFERENCE;
+        if (JsDiagGetSource(static_cast<unsigned int>(scriptId), &sourceInfo) != JsNoError)
+        {
+            return false;
+        }
+
+        return PropertyHelpers::TryGetString(sourceInfo, "source", source);
+    }
+
+    int Debugger::SetBreakpointByUrl(
+        const std::string& url,
+        int line,
+        int column,
+        std::vector<SourceLocation>* locations)
+    {
+        int breakpointId = m_nextBreakpointId++;
+        Breakpoint& breakpoint = m_breakpoints[breakpointId];
+        breakpoint.url = url;
+        breakpoint.line = line;
+        breakpoint.column = column;
+
+        for (int scriptId : m_scripts.FindByUrl(url))
+        {
+            SourceLocation location = {};
+            if (ResolveBreakpoint(breakpointId, &breakpoint, scriptId, &location))
+            {
+                locations->push_back(location);
+            }
+        }
+
+        return breakpointId;
+    }
+
+    bool Debugger::RemoveBreakpoint(int breakpointId)
+    {
+        auto it = m_breakpoints.find(breakpointId);
+        if (it == m_breakpoints.end())
+        {
+            return false;
+        }
+
+        for (int engineId : it->second.engineIds)
+        {
+            // The breakpoint may already be gone if its script was unloaded, which is fine.
+            JsDiagRemoveBreakpoint(static_cast<unsigned int>(engineId));
+            m_engineBreakpoints.erase(engineId);
+        }
+
+        m_breakpoints.erase(it);
+        return true;
+    }
+
+    void Debugger::SetBreakOnException(JsDiagBreakOnExceptionAttributes attributes)
+    {
+        IfJsErrorThrow(JsDiagSetBreakOnException(m_runtime, attributes), "failed to set break on exception");
+    }
+
+    void Debugger::SetExceptionFilter(ExceptionFilter filter)
+    {
+        m_exceptionFilter = std::move(filter);
+    }
+
+    void Debugger::SetBlackboxPatterns(const std::vector<std::string>& patterns)
+    {
+        m_blackbox.SetPatterns(patterns);
+    }
+
+    bool Debugger::SetBlackboxedRanges(int scriptId, std::vector<BlackboxIndex::Position> positions)
+    {
+        return m_blackbox.SetRanges(scriptId, std::move(positions));
+    }
+
+    bool Debugger::IsPaused() const
+    {
+        return m_paused;
+    }
+
+    void Debugger::Resume()
+    {
+        m_stepping = false;
+        m_paused = false;
+    }
+
+    bool Debugger::Step(JsDiagStepType stepType)
+    {
+        if (JsDiagSetStepType(stepType) != JsNoError)
+        {
+            return false;
+        }
+
+        m_stepping = true;
+        m_stepType = stepType;
+        m_blackboxedStepCount = 0;
+        m_paused = false;
+        return true;
+    }
+
+    bool Debugger::ContinueToLocation(int scriptId, int line, int column)
+    {
+        const ScriptInfo* script = m_scripts.Find(scriptId);
+        if (script == nullptr)
+        {
+            return false;
+        }
+
+        SourceLocation target = { scriptId, line, column };
+        if (script->generatedScriptId != -1 && !m_scripts.ToGenerated(target, &target))
+        {
+            return false;
+        }
+
+        RemoveOneShotBreakpoint();
+
+        JsValueRef breakpoint = JS_INVALID_REFERENCE;
+        JsErrorCode result = JsDiagSetBreakpoint(
+            static_cast<unsigned int>(target.scriptId),
+            static_cast<unsigned int>(target.line),
+            static_cast<unsigned int>(target.column),
+            &breakpoint);
+
+        if (result != JsNoError)
+        {
+            return false;
+        }
+
+        PropertyHelpers::TryGetInt(breakpoint, "breakpointId", &m_oneShotBreakpointId);
+
+        m_stepping = false;
+        m_paused = false;
+        return true;
+    }
+
+    uint32_t Debugger::CaptureStackTrace(StackTracePool* pool, size_t maxFrames)
+    {
+        JsValueRef stackTrace = JS_INVALID_REFERENCE;
+        IfJsErrorThrow(JsDiagGetStackTrace(&stackTrace), "failed to get stack trace");
+
+        int length = 0;
+        PropertyHelpers::TryGetInt(stackTrace, "length", &length);
+
+        int frameCount = static_cast<int>((std::min)(static_cast<size_t>(length), maxFrames));
+        pool->EnsureCapacity(frameCount);
+
+        // Intern from the outermost frame inwards so that stacks with the same callers share nodes.
+        uint32_t stackId = StackTracePool::kEmptyStack;
+
+        for (int i = frameCount - 1; i >= 0; i--)
+        {
+            JsValueRef frame = JS_INVALID_REFERENCE;
+            int scriptId = 0;
+            int line = 0;
+            int column = 0;
+
+            if (!PropertyHelpers::TryGetIndexedProperty(stackTrace, i, &frame) ||
+                !PropertyHelpers::TryGetInt(frame, "scriptId", &scriptId) ||
+                !PropertyHelpers::TryGetInt(frame, "line", &line) ||
+                !PropertyHelpers::TryGetInt(frame, "column", &column))
+            {
+                continue;
+            }
+
+            uint32_t frameId = 0;
+            if (!pool->TryGetFrame(scriptId, line, column, &frameId))
+            {
+                // Resolving the function is the expensive part, so it only happens the first time a frame is seen.
+                frameId = pool->AddFrame(scriptId, line, column, GetScriptUrl(scriptId), GetFunctionName(frame));
+            }
+
+            stackId = pool->InternStack(stackId, frameId);
+        }
+
+        return stackId;
+    }
+
+    std::vector<CallFrameInfo> Debugger::GetCallFrames()
+    {
+        JsValueRef stackTrace = JS_INVALID_REFERENCE;
+        IfJsErrorThrow(JsDiagGetStackTrace(&stackTrace), "failed to get stack trace");
+
+        int length = 0;
+        PropertyHelpers::TryGetInt(stackTrace, "length", &length);
+
+        std::vector<CallFrameInfo> callFrames;
+        callFrames.reserve(length);
+
+        for (int i = 0; i < length; i++)
+        {
+            JsValueRef frame = JS_INVALID_REFERENCE;
+            CallFrameInfo info = {};
+
+            if (!PropertyHelpers::TryGetIndexedProperty(stackTrace, i, &frame) ||
+                !PropertyHelpers::TryGetInt(frame, "index", &info.index) ||
+                !PropertyHelpers::TryGetInt(frame, "scriptId", &info.scriptId) ||
+                !PropertyHelpers::TryGetInt(frame, "line", &info.line) ||
+                !PropertyHelpers::TryGetInt(frame, "column", &info.column))
+            {
+                continue;
+            }
+
+            SourceLocation original = {};
+            if (m_scripts.ToOriginal(SourceLocation{ info.scriptId, info.line, info.column }, &original))
+            {
+                info.scriptId = original.scriptId;
+                info.line = original.line;
+                info.column = original.column;
+            }
+
+            info.functionName = GetFunctionName(frame);
+            callFrames.push_back(std::move(info));
+        }
+
+        return callFrames;
+    }
+
     void Debugger::DebugEventCallback(JsDiagDebugEvent debugEvent, JsValueRef eventData, void* callbackState)
     {
         auto protocolHandler = static_cast<Debugger*>(callbackState);
@@ -90,6 +424,13 @@ namespace JsDebug
             return;
         }
 
+        // Steps that haven't reached a stop worth reporting are continued right here, without the frontend ever
+        // seeing them.
+        if (debugEvent == JsDiagDebugEventStepComplete && ContinueStep(eventData))
+        {
+            return;
+        }
+
         if (m_debugCallback != nullptr)
         {
             m_debugCallback(debugEvent, eventData, m_debugCallbackState);
@@ -104,15 +445,23 @@ namespace JsDebug
         case JsDiagDebugEventBreakpoint:
         case JsDiagDebugEventStepComplete:
         case JsDiagDebugEventDebuggerStatement:
+            HandleBreak(debugEvent, eventData);
+            break;
+
         case JsDiagDebugEventRuntimeException:
-            HandleBreak(eventData);
+            // The filter only decides whether to pause; the exception has been reported either way.
+            if (ShouldPauseOnException(eventData))
+            {
+                HandleBreak(debugEvent, eventData);
+            }
+
             break;
 
         case JsDiagDebugEventAsyncBreak:
             if (m_pauseOnNextStatement)
             {
                 m_pauseOnNextStatement = false;
-                HandleBreak(eventData);
+                HandleBreak(debugEvent, eventData);
             }
 
             break;
@@ -121,15 +470,326 @@ namespace JsDebug
 
     void Debugger::HandleSourceEvent(JsValueRef eventData, bool success)
     {
+        RegisterScript(eventData);
+    }
+
+    void Debugger::HandleBreak(JsDiagDebugEvent debugEvent, JsValueRef eventData)
+    {
+        int breakpointId = -1;
+        if (debugEvent == JsDiagDebugEventBreakpoint)
+        {
+            PropertyHelpers::TryGetInt(eventData, "breakpointId", &breakpointId);
+        }
+
+        if (breakpointId != -1)
+        {
+            // Report the breakpoint the frontend set rather than the engine's own, which also leaves out the
+            // one-shot breakpoint.
+            auto it = m_engineBreakpoints.find(breakpointId);
+            breakpointId = it != m_engineBreakpoints.end() ? it->second : -1;
+        }
+
+        RemoveOneShotBreakpoint();
+        m_stepping = false;
+
+        if (m_breakCallback == nullptr)
+        {
+            return;
+        }
 
+        BreakInfo breakInfo = { debugEvent, eventData, breakpointId };
+
+        m_paused = true;
+        m_breakCallback(breakInfo, m_breakCallbackState);
+        m_paused = false;
     }
 
-    void Debugger::HandleBreak(JsValueRef eventData)
+    bool Debugger::ShouldPauseOnException(JsValueRef eventData)
     {
+        if (m_exceptionFilter.IsEmpty())
+        {
+            return true;
+        }
+
+        std::string typeName;
+        JsValueRef exception = JS_INVALID_REFERENCE;
+        if (PropertyHelpers::TryGetProperty(eventData, "exception", &exception))
+        {
+            PropertyHelpers::TryGetString(exception, "className", &typeName);
+
+            // All of the built-in error types share a class name, but they are displayed as "<name>: <message>".
+            std::string display;
+            if (typeName == "Error" && PropertyHelpers::TryGetString(exception, "display", &display))
+            {
+                size_t colon = display.find(':');
+                if (colon != std::string::npos)
+                {
+                    typeName = display.substr(0, colon);
+                }
+            }
+        }
+
+        if (!m_exceptionFilter.MatchesType(typeName))
+        {
+            return false;
+        }
+
+        if (m_exceptionFilter.NeedsUrl())
+        {
+            std::string url;
+            int scriptId = 0;
+            if (PropertyHelpers::TryGetInt(eventData, "scriptId", &scriptId))
+            {
+                url = GetScriptUrl(scriptId);
+            }
+
+            if (!m_exceptionFilter.MatchesUrl(url))
+            {
+                return false;
+            }
+        }
+
+        return m_exceptionFilter.TryAcquirePause();
+    }
+
+    bool Debugger::ContinueStep(JsValueRef eventData)
+    {
+        if (!m_stepping)
+        {
+            return false;
+        }
+
+        // Stepping out of (or over the end of) user code into a library frame, and stepping into library code, both
+        // end up here; either way the step continues until it reaches a frame the user cares about.
+        return SkipBlackboxedStep(eventData);
+    }
+
+    bool Debugger::SkipBlackboxedStep(JsValueRef eventData)
+    {
+        int scriptId = 0;
+        int line = 0;
+        int column = 0;
+
+        if (m_blackbox.IsEmpty() ||
+            !PropertyHelpers::TryGetInt(eventData, "scriptId", &scriptId) ||
+            !PropertyHelpers::TryGetInt(eventData, "line", &line) ||
+            !PropertyHelpers::TryGetInt(eventData, "column", &column))
+        {
+            m_blackboxedStepCount = 0;
+            return false;
+        }
+
+        // Bundled code is blackboxed by the original source it came from as well as by the bundle itself.
+        SourceLocation original = {};
+        if (!m_blackbox.IsBlackboxed(scriptId, line, column) &&
+            !(m_scripts.ToOriginal(SourceLocation{ scriptId, line, column }, &original) &&
+                m_blackbox.IsBlackboxed(original.scriptId, original.line, original.column)))
+        {
+            m_blackboxedStepCount = 0;
+            return false;
+        }
+
+        // Stepping in finds the way back into user code through callbacks as well as returns, but a long stretch of
+        // framework code is left faster by stepping out.
+        JsDiagStepType stepType = JsDiagStepTypeStepIn;
+        if (m_stepType == JsDiagStepTypeStepOut || ++m_blackboxedStepCount > kMaxBlackboxedStepIns)
+        {
+            stepType = JsDiagStepTypeStepOut;
+        }
+
+        IfJsErrorThrow(JsDiagSetStepType(stepType), "failed to set step type");
+        return true;
+    }
+
+    void Debugger::RemoveOneShotBreakpoint()
+    {
+        if (m_oneShotBreakpointId == -1)
+        {
+            return;
+        }
+
+        // The breakpoint may already be gone if its script was unloaded, which is fine.
+        JsDiagRemoveBreakpoint(static_cast<unsigned int>(m_oneShotBreakpointId));
+        m_oneShotBreakpointId = -1;
+    }
+
+    bool Debugger::ResolveBreakpoint(
+        int breakpointId,
+        Breakpoint* breakpoint,
+        int scriptId,
+        SourceLocation* location)
+    {
+        const ScriptInfo* script = m_scripts.Find(scriptId);
+        if (script == nullptr)
+        {
+            return false;
+        }
+
+        SourceLocation target = { scriptId, breakpoint->line, breakpoint->column };
+        bool isOriginalSource = script->generatedScriptId != -1;
 
+        if (isOriginalSource && !m_scripts.ToGenerated(target, &target))
+        {
+            return false;
+        }
+
+        JsValueRef engineBreakpoint = JS_INVALID_REFERENCE;
+        if (JsDiagSetBreakpoint(
+                static_cast<unsigned int>(target.scriptId),
+                static_cast<unsigned int>(target.line),
+                static_cast<unsigned int>(target.column),
+                &engineBreakpoint) != JsNoError)
+        {
+            return false;
+        }
+
+        int engineId = -1;
+        if (!PropertyHelpers::TryGetInt(engineBreakpoint, "breakpointId", &engineId))
+        {
+            return false;
+        }
+
+        // The engine moves the breakpoint to the nearest statement.
+        PropertyHelpers::TryGetInt(engineBreakpoint, "line", &target.line);
+        PropertyHelpers::TryGetInt(engineBreakpoint, "column", &target.column);
+
+        breakpoint->engineIds.push_back(engineId);
+        m_engineBreakpoints[engineId] = breakpointId;
+
+        *location = target;
+        if (isOriginalSource)
+        {
+            m_scripts.ToOriginal(target, location);
+        }
+
+        return true;
     }
 
     void Debugger::ClearBreakpoints()
     {
+        for (const auto& engineBreakpoint : m_engineBreakpoints)
+        {
+            JsDiagRemoveBreakpoint(static_cast<unsigned int>(engineBreakpoint.first));
+        }
+
+        m_engineBreakpoints.clear();
+        m_breakpoints.clear();
+    }
+
+    void Debugger::LoadScripts()
+    {
+        JsValueRef scripts = JS_INVALID_REFERENCE;
+        IfJsErrorThrow(JsDiagGetScripts(&scripts), "failed to get scripts");
+
+        int length = 0;
+        PropertyHelpers::TryGetInt(scripts, "length", &length);
+
+        for (int i = 0; i < length; i++)
+        {
+            JsValueRef script = JS_INVALID_REFERENCE;
+            if (PropertyHelpers::TryGetIndexedProperty(scripts, i, &script))
+            {
+                RegisterScript(script);
+            }
+        }
+    }
+
+    void Debugger::RegisterScript(JsValueRef scriptData)
+    {
+        int scriptId = 0;
+        if (!PropertyHelpers::TryGetInt(scriptData, "scriptId", &scriptId))
+        {
+            return;
+        }
+
+        if (m_scripts.Find(scriptId) != nullptr)
+        {
+            return;
+        }
+
+        std::string url;
+        int lineCount = 0;
+        PropertyHelpers::TryGetString(scriptData, "fileName", &url);
+        PropertyHelpers::TryGetInt(scriptData, "lineCount", &lineCount);
+
+        std::vector<int> addedIds;
+        m_scripts.AddScript(scriptId, url, lineCount, FindSourceMappingUrl(scriptId), &addedIds);
+
+        for (int addedId : addedIds)
+        {
+            const ScriptInfo& script = *m_scripts.Find(addedId);
+            m_blackbox.AddScript(addedId, script.url);
+
+            if (m_scriptCallback != nullptr)
+            {
+                m_scriptCallback(script, m_scriptCallbackState);
+            }
+
+            for (auto& breakpoint : m_breakpoints)
+            {
+                SourceLocation location = {};
+                if (breakpoint.second.url == script.url &&
+                    ResolveBreakpoint(breakpoint.first, &breakpoint.second, addedId, &location) &&
+                    m_breakpointCallback != nullptr)
+                {
+                    m_breakpointCallback(breakpoint.first, location, m_breakpointCallbackState);
+                }
+            }
+        }
+    }
+
+    std::string Debugger::GetScriptUrl(int scriptId) const
+    {
+        const ScriptInfo* script = m_scripts.Find(scriptId);
+        return script != nullptr ? script->url : std::string();
+    }
+
+    std::string Debugger::FindSourceMappingUrl(int scriptId)
+    {
+        JsValueRef sourceInfo = JS_INVALID_REFERENCE;
+        JsValueRef source = JS_INVALID_REFERENCE;
+        int length = 0;
+
+        if (JsDiagGetSource(static_cast<unsigned int>(scriptId), &sourceInfo) != JsNoError ||
+            !PropertyHelpers::TryGetProperty(sourceInfo, "source", &source) ||
+            JsGetStringLength(source, &length) != JsNoError)
+        {
+            return std::string();
+        }
+
+        // Copying the whole of a large bundle just to look at its last line would dominate the cost of loading it.
+        int start = (std::max)(0, length - kSourceMappingUrlSearchLength);
+        std::vector<uint16_t> buffer(length - start);
+        size_t written = 0;
+
+        if (buffer.empty() ||
+            JsCopyStringUtf16(source, start, length - start, buffer.data(), &written) != JsNoError)
+        {
+            return std::string();
+        }
+
+        // URLs are ASCII, so anything else only needs to not be mistaken for part of one.
+        std::string tail(written, ' ');
+        for (size_t i = 0; i < written; i++)
+        {
+            tail[i] = buffer[i] < 0x80 ? static_cast<char>(buffer[i]) : '?';
+        }
+
+        return ParseSourceMappingUrl(tail);
+    }
+
+    std::string Debugger::GetFunctionName(JsValueRef frame)
+    {
+        std::string functionName;
+        int functionHandle = 0;
+        JsValueRef function = JS_INVALID_REFERENCE;
+
+        if (PropertyHelpers::TryGetInt(frame, "functionHandle", &functionHandle) &&
+            JsDiagGetObjectFromHandle(functionHandle, &function) == JsNoError)
+        {
+            PropertyHelpers::TryGetString(function, "name", &functionName);
+        }
+
+        return functionName;
     }
 }
@@ -7,10 +7,49 @@
 
 #include <ChakraCore.h>
 
+#include "BlackboxIndex.h"
+#include "ExceptionFilter.h"
+#include "ScriptRegistry.h"
+#include "StackTracePool.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace JsDebug
 {
+    struct BreakInfo
+    {
+        JsDiagDebugEvent debugEvent;
+        JsValueRef eventData;
+
+        // The user breakpoint that caused the break, or -1 if there wasn't one.
+        int breakpointId;
+    };
+
+    struct CallFrameInfo
+    {
+        int index;
+        int scriptId;
+        int line;
+        int column;
+        std::string functionName;
+    };
+
     typedef void (*DebuggerMessageHandler)(void* callbackState);
 
+    // Called when the engine stops in a way the frontend should see. Execution continues once the handler returns,
+    // so the handler is expected to process commands until one of them resumes the debugger.
+    typedef void (*DebuggerBreakHandler)(const BreakInfo& breakInfo, void* callbackState);
+
+    // Called for every script the debugger learns about, including the original sources of a source map.
+    typedef void (*DebuggerScriptHandler)(const ScriptInfo& script, void* callbackState);
+
+    // Called when a breakpoint set by URL is resolved in a script that was loaded after it was set.
+    typedef void (*DebuggerBreakpointHandler)(int breakpointId, const SourceLocation& location, void* callbackState);
+
     class Debugger
     {
     public:
@@ -23,6 +62,39 @@ namespace JsDebug
         void RequestAsyncBreak();
         void SetMessageHandler(DebuggerMessageHandler callback, void* callbackState);
         void SetDebugEventHandler(JsDiagDebugEventCallback callback, void* callbackState);
+        void SetBreakHandler(DebuggerBreakHandler callback, void* callbackState);
+        void SetScriptHandler(DebuggerScriptHandler callback, void* callbackState);
+        void SetBreakpointHandler(DebuggerBreakpointHandler callback, void* callbackState);
+
+        const ScriptRegistry& Scripts() const;
+        void SetMaxSourceMapFileSize(size_t maxFileSize);
+        bool GetScriptSource(int scriptId, std::string* source);
+
+        // Breakpoints by URL also apply to scripts loaded later. Locations in original sources are set at the
+        // matching generated location, and reported back in terms of the original source. Returns the id of the
+        // breakpoint; the locations it was resolved to so far are appended to locations.
+        int SetBreakpointByUrl(const std::string& url, int line, int column, std::vector<SourceLocation>* locations);
+        bool RemoveBreakpoint(int breakpointId);
+
+        void SetBreakOnException(JsDiagBreakOnExceptionAttributes attributes);
+        void SetExceptionFilter(ExceptionFilter filter);
+
+        void SetBlackboxPatterns(const std::vector<std::string>& patterns);
+        bool SetBlackboxedRanges(int scriptId, std::vector<BlackboxIndex::Position> positions);
+
+        // May be called from any thread.
+        bool IsPaused() const;
+
+        // These resume execution and are only valid while paused. Step and ContinueToLocation return false, and leave
+        // the engine paused, if the engine rejects the step or the location. A location in an original source is
+        // continued to at the matching generated location.
+        void Resume();
+        bool Step(JsDiagStepType stepType);
+        bool ContinueToLocation(int scriptId, int line, int column);
+
+        // Only valid while the engine is broken into the debugger. Returns the id of the stack in the pool.
+        uint32_t CaptureStackTrace(StackTracePool* pool, size_t maxFrames);
+        std::vector<CallFrameInfo> GetCallFrames();
 
     private:
         static void CHAKRA_CALLBACK DebugEventCallback(
@@ -32,16 +104,58 @@ namespace JsDebug
 
         void HandleDebugEvent(JsDiagDebugEvent debugEvent, JsValueRef eventData);
         void HandleSourceEvent(JsValueRef eventData, bool success);
-        void HandleBreak(JsValueRef eventData);
+        void HandleBreak(JsDiagDebugEvent debugEvent, JsValueRef eventData);
+        bool ShouldPauseOnException(JsValueRef eventData);
+        bool ContinueStep(JsValueRef eventData);
+        bool SkipBlackboxedStep(JsValueRef eventData);
+        void RemoveOneShotBreakpoint();
 
+        struct Breakpoint
+        {
+            std::string url;
+            int line;
+            int column;
+            std::vector<int> engineIds;
+        };
+
+        bool ResolveBreakpoint(int breakpointId, Breakpoint* breakpoint, int scriptId, SourceLocation* location);
         void ClearBreakpoints();
+        void LoadScripts();
+        void RegisterScript(JsValueRef scriptData);
+        std::string GetScriptUrl(int scriptId) const;
+        static std::string FindSourceMappingUrl(int scriptId);
+        static std::string GetFunctionName(JsValueRef frame);
 
         JsRuntimeHandle m_runtime;
         DebuggerMessageHandler m_messageCallback;
         void* m_messageCallbackState;
         JsDiagDebugEventCallback m_debugCallback;
         void* m_debugCallbackState;
+        DebuggerBreakHandler m_breakCallback;
+        void* m_breakCallbackState;
+        DebuggerScriptHandler m_scriptCallback;
+        void* m_scriptCallbackState;
+        DebuggerBreakpointHandler m_breakpointCallback;
+        void* m_breakpointCallbackState;
         bool m_enabled;
         bool m_pauseOnNextStatement;
+        std::atomic<bool> m_paused;
+
+        ExceptionFilter m_exceptionFilter;
+        ScriptRegistry m_scripts;
+
+        std::map<int, Breakpoint> m_breakpoints;
+        std::unordered_map<int, int> m_engineBreakpoints;
+        int m_nextBreakpointId;
+
+        BlackboxIndex m_blackbox;
+
+        // A step requested by the frontend stays in progress until the engine stops somewhere worth reporting.
+        bool m_stepping;
+        JsDiagStepType m_stepType;
+        int m_blackboxedStepCount;
+
+        // Temporary breakpoint used by continueToLocation, removed on the next break whatever caused it.
+        int m_oneShotBreakpointId;
     };
 }
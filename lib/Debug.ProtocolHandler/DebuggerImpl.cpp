@@ -9,11 +9,60 @@
 #include "ProtocolHandler.h"
 #include "Debugger.h"
 
+#include <cstdlib>
+
 namespace JsDebug
 {
+    namespace
+    {
+        const char kNotPausedError[] = "Can only perform operation while paused.";
+
+        std::vector<std::string> ToStringVector(protocol::Array<String>* values)
+        {
+            std::vector<std::string> result;
+
+            if (values != nullptr)
+            {
+                result.reserve(values->length());
+
+                for (size_t i = 0; i < values->length(); i++)
+                {
+                    result.push_back(values->get(i).toUTF8());
+                }
+            }
+
+            return result;
+        }
+
+        bool TryParseScriptId(const String& scriptId, int* result)
+        {
+            std::string value = scriptId.toUTF8();
+            char* end = nullptr;
+            long parsed = std::strtol(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0')
+            {
+                return false;
+            }
+
+            *result = static_cast<int>(parsed);
+            return true;
+        }
+
+        std::unique_ptr<protocol::Debugger::Location> ToProtocolLocation(const SourceLocation& location)
+        {
+            return protocol::Debugger::Location::create()
+                .setScriptId(String(std::to_string(location.scriptId).c_str()))
+                .setLineNumber(location.line)
+                .setColumnNumber(location.column)
+                .build();
+        }
+    }
+
     DebuggerImpl::DebuggerImpl(ProtocolHandler* handler, Debugger* debugger)
         : m_handler(handler)
         , m_debugger(debugger)
+        , m_frontend(handler)
         , m_enabled(false)
     {
     }
@@ -22,6 +71,88 @@ namespace JsDebug
     {
     }
 
+    void DebuggerImpl::SendPausedEvent(
+        const BreakInfo& breakInfo,
+        const std::vector<CallFrameInfo>& callFrames,
+        std::unique_ptr<protocol::Runtime::StackTrace> asyncStackTrace)
+    {
+        auto protocolCallFrames = protocol::Array<protocol::Debugger::CallFrame>::create();
+
+        for (const auto& frame : callFrames)
+        {
+            protocolCallFrames->addItem(protocol::Debugger::CallFrame::create()
+                .setCallFrameId(String(std::to_string(frame.index).c_str()))
+                .setFunctionName(String::fromUTF8(frame.functionName.c_str(), frame.functionName.length()))
+                .setLocation(ToProtocolLocation(SourceLocation{ frame.scriptId, frame.line, frame.column }))
+                .setScopeChain(protocol::Array<protocol::Debugger::Scope>::create())
+                .setThis(protocol::Runtime::RemoteObject::create()
+                    .setType(protocol::Runtime::RemoteObject::TypeEnum::Undefined)
+                    .build())
+                .build());
+        }
+
+        namespace ReasonEnum = protocol::Debugger::Paused::ReasonEnum;
+        const char* reason = breakInfo.debugEvent == JsDiagDebugEventRuntimeException
+            ? ReasonEnum::Exception
+            : ReasonEnum::Other;
+
+        Maybe<protocol::Array<String>> hitBreakpoints;
+        if (breakInfo.breakpointId != -1)
+        {
+            auto breakpoints = protocol::Array<String>::create();
+            breakpoints->addItem(String(std::to_string(breakInfo.breakpointId).c_str()));
+            hitBreakpoints = std::move(breakpoints);
+        }
+
+        m_frontend.paused(
+            std::move(protocolCallFrames),
+            reason,
+            Maybe<protocol::DictionaryValue>(),
+            std::move(hitBreakpoints),
+            std::move(asyncStackTrace));
+        m_frontend.flush();
+    }
+
+    void DebuggerImpl::SendResumedEvent()
+    {
+        m_frontend.resumed();
+        m_frontend.flush();
+    }
+
+    void DebuggerImpl::SendScriptParsed(const ScriptInfo& script)
+    {
+        Maybe<String> sourceMapUrl;
+        if (!script.sourceMapUrl.empty())
+        {
+            sourceMapUrl = String::fromUTF8(script.sourceMapUrl.c_str(), script.sourceMapUrl.length());
+        }
+
+        m_frontend.scriptParsed(
+            String(std::to_string(script.scriptId).c_str()),
+            String::fromUTF8(script.url.c_str(), script.url.length()),
+            0,
+            0,
+            script.endLine,
+            script.endColumn,
+            ProtocolHandler::kExecutionContextId,
+            String(),
+            Maybe<protocol::DictionaryValue>(),
+            Maybe<bool>(),
+            std::move(sourceMapUrl),
+            Maybe<bool>());
+    }
+
+    void DebuggerImpl::SendBreakpointResolved(int breakpointId, const SourceLocation& location)
+    {
+        m_frontend.breakpointResolved(String(std::to_string(breakpointId).c_str()), ToProtocolLocation(location));
+        m_frontend.flush();
+    }
+
+    bool DebuggerImpl::IsEnabled() const
+    {
+        return m_enabled;
+    }
+
     Response DebuggerImpl::enable()
     {
         if (m_enabled)
@@ -29,10 +160,15 @@ namespace JsDebug
             return Response::OK();
         }
 
-        m_enabled = true;
+        // Scripts found while enabling the debugger are reported below along with the ones it already knew about.
         m_debugger->Enable();
+        m_enabled = true;
 
-        // Raise events for all loaded scripts
+        const ScriptRegistry& scripts = m_debugger->Scripts();
+        for (int scriptId : scripts.ScriptIds())
+        {
+            SendScriptParsed(*scripts.Find(scriptId));
+        }
 
         return Response::OK();
     }
@@ -61,7 +197,37 @@ namespace JsDebug
         String  *out_breakpointId,
         std::unique_ptr<protocol::Array<protocol::Debugger::Location>>* out_locations)
     {
-        return Response();
+        if (in_urlRegex.isJust())
+        {
+            return Response::Error("urlRegex is not supported");
+        }
+
+        if (!in_url.isJust())
+        {
+            return Response::Error("Either url or urlRegex must be specified.");
+        }
+
+        if (!in_condition.fromMaybe(String()).empty())
+        {
+            return Response::Error("Conditional breakpoints are not supported");
+        }
+
+        std::vector<SourceLocation> locations;
+        int breakpointId = m_debugger->SetBreakpointByUrl(
+            in_url.fromJust().toUTF8(),
+            in_lineNumber,
+            in_columnNumber.fromMaybe(0),
+            &locations);
+
+        *out_breakpointId = String(std::to_string(breakpointId).c_str());
+        *out_locations = protocol::Array<protocol::Debugger::Location>::create();
+
+        for (const auto& location : locations)
+        {
+            (*out_locations)->addItem(ToProtocolLocation(location));
+        }
+
+        return Response::OK();
     }
 
     Response DebuggerImpl::setBreakpoint(
@@ -75,27 +241,52 @@ namespace JsDebug
 
     Response DebuggerImpl::removeBreakpoint(const String & in_breakpointId)
     {
-        return Response();
+        int breakpointId = 0;
+        if (!TryParseScriptId(in_breakpointId, &breakpointId) || !m_debugger->RemoveBreakpoint(breakpointId))
+        {
+            return Response::Error("Breakpoint not found");
+        }
+
+        return Response::OK();
     }
 
     Response DebuggerImpl::continueToLocation(std::unique_ptr<protocol::Debugger::Location> in_location)
     {
-        return Response();
+        if (!m_debugger->IsPaused())
+        {
+            return Response::Error(kNotPausedError);
+        }
+
+        int scriptId = 0;
+        if (!TryParseScriptId(in_location->getScriptId(), &scriptId))
+        {
+            return Response::Error("Invalid script id");
+        }
+
+        if (!m_debugger->ContinueToLocation(
+            scriptId,
+            in_location->getLineNumber(),
+            in_location->getColumnNumber(0)))
+        {
+            return Response::Error("Could not continue to the given location");
+        }
+
+        return Response::OK();
     }
 
     Response DebuggerImpl::stepOver()
     {
-        return Response();
+        return Step(JsDiagStepTypeStepOver);
     }
 
     Response DebuggerImpl::stepInto()
     {
-        return Response();
+        return Step(JsDiagStepTypeStepIn);
     }
 
     Response DebuggerImpl::stepOut()
     {
-        return Response();
+        return Step(JsDiagStepTypeStepOut);
     }
 
     Response DebuggerImpl::pause()
@@ -105,7 +296,13 @@ namespace JsDebug
 
     Response DebuggerImpl::resume()
     {
-        return Response();
+        if (!m_debugger->IsPaused())
+        {
+            return Response::Error(kNotPausedError);
+        }
+
+        m_debugger->Resume();
+        return Response::OK();
     }
 
     Response DebuggerImpl::searchInContent(
@@ -139,12 +336,54 @@ namespace JsDebug
 
     Response DebuggerImpl::getScriptSource(const String & in_scriptId, String  *out_scriptSource)
     {
-        return Response();
+        int scriptId = 0;
+        std::string source;
+        if (!TryParseScriptId(in_scriptId, &scriptId) || !m_debugger->GetScriptSource(scriptId, &source))
+        {
+            return Response::Error("No script for id: " + in_scriptId);
+        }
+
+        *out_scriptSource = String::fromUTF8(source.c_str(), source.length());
+        return Response::OK();
     }
 
-    Response DebuggerImpl::setPauseOnExceptions(const String & in_state)
+    Response DebuggerImpl::setPauseOnExceptions(
+        const String & in_state,
+        Maybe<protocol::Array<String>> in_exceptionTypes,
+        Maybe<protocol::Array<String>> in_urlPatterns,
+        Maybe<int> in_maxPausesPerSecond)
     {
-        return Response();
+        namespace StateEnum = protocol::Debugger::SetPauseOnExceptions::StateEnum;
+
+        JsDiagBreakOnExceptionAttributes attributes = JsDiagBreakOnExceptionAttributeNone;
+
+        if (in_state == StateEnum::None)
+        {
+            attributes = JsDiagBreakOnExceptionAttributeNone;
+        }
+        else if (in_state == StateEnum::Uncaught)
+        {
+            attributes = JsDiagBreakOnExceptionAttributeUncaught;
+        }
+        else if (in_state == StateEnum::All)
+        {
+            attributes = static_cast<JsDiagBreakOnExceptionAttributes>(
+                JsDiagBreakOnExceptionAttributeUncaught | JsDiagBreakOnExceptionAttributeFirstChance);
+        }
+        else
+        {
+            return Response::Error("Unknown pause on exceptions mode: " + in_state);
+        }
+
+        ExceptionFilter filter;
+        filter.SetExceptionTypes(ToStringVector(in_exceptionTypes.fromMaybe(nullptr)));
+        filter.SetUrlPatterns(ToStringVector(in_urlPatterns.fromMaybe(nullptr)));
+        filter.SetMaxPausesPerSecond(in_maxPausesPerSecond.fromMaybe(0));
+
+        m_debugger->SetBreakOnException(attributes);
+        m_debugger->SetExceptionFilter(std::move(filter));
+
+        return Response::OK();
     }
 
     Response DebuggerImpl::evaluateOnCallFrame(
@@ -172,18 +411,68 @@ namespace JsDebug
 
     Response DebuggerImpl::setAsyncCallStackDepth(int in_maxDepth)
     {
-        return Response();
+        m_handler->SetAsyncCallStackDepth(in_maxDepth);
+        return Response::OK();
     }
 
     Response DebuggerImpl::setBlackboxPatterns(std::unique_ptr<protocol::Array<String>> in_patterns)
     {
-        return Response();
+        try
+        {
+            m_debugger->SetBlackboxPatterns(ToStringVector(in_patterns.get()));
+        }
+        catch (const std::regex_error&)
+        {
+            return Response::Error("Pattern parser error");
+        }
+
+        return Response::OK();
     }
 
     Response DebuggerImpl::setBlackboxedRanges(
         const String & in_scriptId,
         std::unique_ptr<protocol::Array<protocol::Debugger::ScriptPosition>> in_positions)
     {
-        return Response();
+        int scriptId = 0;
+        if (!TryParseScriptId(in_scriptId, &scriptId))
+        {
+            return Response::Error("Invalid script id");
+        }
+
+        std::vector<BlackboxIndex::Position> positions;
+        positions.reserve(in_positions->length());
+
+        for (size_t i = 0; i < in_positions->length(); i++)
+        {
+            protocol::Debugger::ScriptPosition* position = in_positions->get(i);
+            if (position->getLineNumber() < 0 || position->getColumnNumber() < 0)
+            {
+                return Response::Error("Positions must not be negative");
+            }
+
+            positions.push_back(BlackboxIndex::Position{ position->getLineNumber(), position->getColumnNumber() });
+        }
+
+        if (!m_debugger->SetBlackboxedRanges(scriptId, std::move(positions)))
+        {
+            return Response::Error("Positions must be sorted and unique");
+        }
+
+        return Response::OK();
+    }
+
+    Response DebuggerImpl::Step(JsDiagStepType stepType)
+    {
+        if (!m_debugger->IsPaused())
+        {
+            return Response::Error(kNotPausedError);
+        }
+
+        if (!m_debugger->Step(stepType))
+        {
+            return Response::Error("Could not step");
+        }
+
+        return Response::OK();
     }
-}
\ No newline at end of file
+}
@@ -24,6 +24,18 @@ namespace JsDebug
         DebuggerImpl(ProtocolHandler* handler, Debugger* debugger);
         ~DebuggerImpl() override;
 
+        void SendPausedEvent(
+            const BreakInfo& breakInfo,
+            const std::vector<CallFrameInfo>& callFrames,
+            std::unique_ptr<protocol::Runtime::StackTrace> asyncStackTrace);
+        void SendResumedEvent();
+
+        // Doesn't flush, so that the scripts reported by enable() are sent as one batch.
+        void SendScriptParsed(const ScriptInfo& script);
+        void SendBreakpointResolved(int breakpointId, const SourceLocation& location);
+
+        bool IsEnabled() const;
+
         // protocol::Debugger::Backend implementation
         Response enable() override;
         Response disable() override;
@@ -68,7 +80,11 @@ namespace JsDebug
             std::unique_ptr<protocol::Array<protocol::Debugger::CallFrame>>* out_callFrames,
             Maybe<protocol::Runtime::StackTrace>* out_asyncStackTrace) override;
         Response getScriptSource(const String& in_scriptId, String* out_scriptSource) override;
-        Response setPauseOnExceptions(const String& in_state) override;
+        Response setPauseOnExceptions(
+            const String& in_state,
+            Maybe<protocol::Array<String>> in_exceptionTypes,
+            Maybe<protocol::Array<String>> in_urlPatterns,
+            Maybe<int> in_maxPausesPerSecond) override;
         Response evaluateOnCallFrame(
             const String& in_callFrameId,
             const String& in_expression,
@@ -91,8 +107,11 @@ namespace JsDebug
             std::unique_ptr<protocol::Array<protocol::Debugger::ScriptPosition>> in_positions) override;
 
     private:
+        Response Step(JsDiagStepType stepType);
+
         ProtocolHandler* m_handler;
         Debugger* m_debugger;
+        protocol::Debugger::Frontend m_frontend;
         bool m_enabled;
     };
 }
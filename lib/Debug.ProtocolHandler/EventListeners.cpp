@@ -0,0 +1,228 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "EventListeners.h"
+
+#include <algorithm>
+
+namespace JsDebug
+{
+    namespace
+    {
+        JsDebugStringView ToStringView(const std::string& str)
+        {
+            return JsDebugStringView{ str.data(), str.length() };
+        }
+    }
+
+    EventListeners::EventListeners()
+        : m_listeners(std::make_shared<ListenerList>())
+        , m_nextId(1)
+        , m_eventTypes(0)
+        , m_publishSequence(0)
+        , m_waiters(0)
+    {
+    }
+
+    EventListeners::~EventListeners()
+    {
+    }
+
+    JsDebugEventListener EventListeners::Add(
+        unsigned int eventTypes,
+        JsDebugEventCallback callback,
+        void* callbackState)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        uintptr_t id = m_nextId++;
+        auto listeners = std::make_shared<ListenerList>(*m_listeners);
+        listeners->push_back(Listener{ id, eventTypes, callback, callbackState });
+        Replace(std::move(listeners));
+
+        return reinterpret_cast<JsDebugEventListener>(id);
+    }
+
+    bool EventListeners::Remove(JsDebugEventListener listener)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            uintptr_t id = reinterpret_cast<uintptr_t>(listener);
+            auto it = std::find_if(m_listeners->begin(), m_listeners->end(), [id](const Listener& entry)
+            {
+                return entry.id == id;
+            });
+
+            if (it == m_listeners->end())
+            {
+                return false;
+            }
+
+            auto listeners = std::make_shared<ListenerList>(m_listeners->begin(), it);
+            listeners->insert(listeners->end(), it + 1, m_listeners->end());
+            Replace(std::move(listeners));
+        }
+
+        WaitForPublish();
+        return true;
+    }
+
+    bool EventListeners::IsListening(JsDebugEventType eventType) const
+    {
+        return (m_eventTypes.load(std::memory_order_relaxed) & eventType) != 0;
+    }
+
+    void EventListeners::PublishScriptParsed(const ScriptInfo& script)
+    {
+        if (!IsListening(JsDebugEventTypeScriptParsed))
+        {
+            return;
+        }
+
+        JsDebugEvent event = {};
+        event.type = JsDebugEventTypeScriptParsed;
+        event.data.scriptParsed.scriptId = script.scriptId;
+        event.data.scriptParsed.url = ToStringView(script.url);
+        event.data.scriptParsed.endLine = script.endLine;
+        event.data.scriptParsed.endColumn = script.endColumn;
+        event.data.scriptParsed.sourceMapUrl = ToStringView(script.sourceMapUrl);
+        event.data.scriptParsed.generatedScriptId = script.generatedScriptId;
+
+        Publish(event);
+    }
+
+    void EventListeners::PublishPaused(const BreakInfo& breakInfo, const std::vector<CallFrameInfo>& callFrames)
+    {
+        if (!IsListening(JsDebugEventTypePaused))
+        {
+            return;
+        }
+
+        m_callFrames.clear();
+        for (const auto& frame : callFrames)
+        {
+            m_callFrames.push_back(JsDebugCallFrame{
+                frame.scriptId,
+                frame.line,
+                frame.column,
+                ToStringView(frame.functionName) });
+        }
+
+        JsDebugEvent event = {};
+        event.type = JsDebugEventTypePaused;
+        event.data.paused.reason = breakInfo.debugEvent == JsDiagDebugEventRuntimeException
+            ? JsDebugPauseReasonException
+            : JsDebugPauseReasonOther;
+        event.data.paused.breakpointId = breakInfo.breakpointId;
+        event.data.paused.callFrames = m_callFrames.data();
+        event.data.paused.callFrameCount = m_callFrames.size();
+
+        Publish(event);
+    }
+
+    void EventListeners::PublishResumed()
+    {
+        if (!IsListening(JsDebugEventTypeResumed))
+        {
+            return;
+        }
+
+        JsDebugEvent event = {};
+        event.type = JsDebugEventTypeResumed;
+
+        Publish(event);
+    }
+
+    void EventListeners::PublishConsoleMessage(const JsDebugConsoleMessageEvent& message)
+    {
+        if (!IsListening(JsDebugEventTypeConsoleMessage))
+        {
+            return;
+        }
+
+        JsDebugEvent event = {};
+        event.type = JsDebugEventTypeConsoleMessage;
+        event.data.consoleMessage = message;
+
+        Publish(event);
+    }
+
+    void EventListeners::PublishException(const ExceptionInfo& exception, double timestamp)
+    {
+        if (!IsListening(JsDebugEventTypeException))
+        {
+            return;
+        }
+
+        JsDebugEvent event = {};
+        event.type = JsDebugEventTypeException;
+        event.data.exception.uncaught = exception.uncaught;
+        event.data.exception.text = ToStringView(exception.text);
+        event.data.exception.scriptId = exception.scriptId;
+        event.data.exception.line = exception.line;
+        event.data.exception.column = exception.column;
+        event.data.exception.timestamp = timestamp;
+
+        Publish(event);
+    }
+
+    void EventListeners::Publish(const JsDebugEvent& event)
+    {
+        // Callbacks that add or remove listeners replace the list, so the one being walked here stays intact.
+        std::shared_ptr<const ListenerList> listeners = std::atomic_load(&m_listeners);
+
+        m_publishThread.store(std::this_thread::get_id());
+        m_publishSequence++;
+
+        for (const auto& listener : *listeners)
+        {
+            if ((listener.eventTypes & event.type) != 0)
+            {
+                listener.callback(&event, listener.callbackState);
+            }
+        }
+
+        m_publishSequence++;
+
+        if (m_waiters.load() != 0)
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_published.notify_all();
+        }
+    }
+
+    void EventListeners::Replace(std::shared_ptr<const ListenerList> listeners)
+    {
+        unsigned int eventTypes = 0;
+        for (const auto& listener : *listeners)
+        {
+            eventTypes |= listener.eventTypes;
+        }
+
+        std::atomic_store(&m_listeners, std::move(listeners));
+        m_eventTypes.store(eventTypes, std::memory_order_relaxed);
+    }
+
+    void EventListeners::WaitForPublish()
+    {
+        uint64_t sequence = m_publishSequence.load();
+        if ((sequence & 1) == 0 || m_publishThread.load() == std::this_thread::get_id())
+        {
+            return;
+        }
+
+        // Events published after the list was replaced don't include the removed listener, so only the one in
+        // progress has to finish.
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_waiters++;
+        m_published.wait(lock, [this, sequence]()
+        {
+            return m_publishSequence.load() != sequence;
+        });
+        m_waiters--;
+    }
+}
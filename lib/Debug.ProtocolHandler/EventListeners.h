@@ -0,0 +1,88 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ChakraDebugProtocolHandler.h"
+#include "Debugger.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace JsDebug
+{
+    struct ExceptionInfo
+    {
+        bool uncaught;
+        std::string text;
+        int scriptId;
+        int line;
+        int column;
+    };
+
+    //
+    // Native listeners for debug events. Events are published from the same structures the protocol agents build
+    // their messages from, and passed to the listeners as views over them, so nothing is serialized for a listener.
+    // The list is replaced rather than changed in place, so publishing an event takes a reference to the current list
+    // without locking or copying it. The type mask is kept separately so that the script thread can skip gathering an
+    // event nobody listens to altogether.
+    //
+    class EventListeners
+    {
+    public:
+        EventListeners();
+        ~EventListeners();
+
+        // May be called from any thread. Remove waits for an event being delivered on another thread to finish, so
+        // the callback isn't running once it returns; called from a callback, it doesn't wait.
+        JsDebugEventListener Add(unsigned int eventTypes, JsDebugEventCallback callback, void* callbackState);
+        bool Remove(JsDebugEventListener listener);
+        bool IsListening(JsDebugEventType eventType) const;
+
+        // These are only called from the script thread.
+        void PublishScriptParsed(const ScriptInfo& script);
+        void PublishPaused(const BreakInfo& breakInfo, const std::vector<CallFrameInfo>& callFrames);
+        void PublishResumed();
+        void PublishConsoleMessage(const JsDebugConsoleMessageEvent& message);
+        void PublishException(const ExceptionInfo& exception, double timestamp);
+
+    private:
+        struct Listener
+        {
+            uintptr_t id;
+            unsigned int eventTypes;
+            JsDebugEventCallback callback;
+            void* callbackState;
+        };
+
+        typedef std::vector<Listener> ListenerList;
+
+        void Publish(const JsDebugEvent& event);
+        void Replace(std::shared_ptr<const ListenerList> listeners);
+        void WaitForPublish();
+
+        // Guards replacing the list, not reading it.
+        std::mutex m_lock;
+        std::shared_ptr<const ListenerList> m_listeners;
+        uintptr_t m_nextId;
+        std::atomic<unsigned int> m_eventTypes;
+
+        // Odd while an event is being delivered. Removing a listener waits for it to change, unless it is being
+        // removed by a callback on the publishing thread.
+        std::atomic<uint64_t> m_publishSequence;
+        std::atomic<std::thread::id> m_publishThread;
+        std::atomic<unsigned int> m_waiters;
+        std::condition_variable m_published;
+
+        // Reused for every paused event so that a deep stack doesn't cost an allocation each time.
+        std::vector<JsDebugCallFrame> m_callFrames;
+    };
+}
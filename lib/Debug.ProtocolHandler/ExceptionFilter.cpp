@@ -0,0 +1,179 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "ExceptionFilter.h"
+
+namespace JsDebug
+{
+    ExceptionFilter::ExceptionFilter()
+        : m_maxPausesPerSecond(0)
+        , m_pausesInWindow(0)
+    {
+    }
+
+    ExceptionFilter::~ExceptionFilter()
+    {
+    }
+
+    void ExceptionFilter::SetExceptionTypes(const std::vector<std::string>& types)
+    {
+        m_types.clear();
+        m_types.insert(types.begin(), types.end());
+    }
+
+    void ExceptionFilter::SetUrlPatterns(const std::vector<std::string>& patterns)
+    {
+        m_urlPatterns.clear();
+
+        for (const auto& pattern : patterns)
+        {
+            m_urlPatterns.emplace_back(pattern);
+        }
+    }
+
+    void ExceptionFilter::SetMaxPausesPerSecond(int maxPausesPerSecond)
+    {
+        m_maxPausesPerSecond = maxPausesPerSecond > 0 ? maxPausesPerSecond : 0;
+        m_pausesInWindow = 0;
+        m_windowStart = clock::time_point();
+    }
+
+    void ExceptionFilter::Clear()
+    {
+        m_types.clear();
+        m_urlPatterns.clear();
+        SetMaxPausesPerSecond(0);
+    }
+
+    bool ExceptionFilter::IsEmpty() const
+    {
+        return m_types.empty() && m_urlPatterns.empty() && m_maxPausesPerSecond == 0;
+    }
+
+    bool ExceptionFilter::NeedsUrl() const
+    {
+        return !m_urlPatterns.empty();
+    }
+
+    bool ExceptionFilter::MatchesType(const std::string& typeName) const
+    {
+        return m_types.empty() || m_types.find(typeName) != m_types.end();
+    }
+
+    bool ExceptionFilter::MatchesUrl(const std::string& url) const
+    {
+        if (m_urlPatterns.empty())
+        {
+            return true;
+        }
+
+        for (const auto& pattern : m_urlPatterns)
+        {
+            if (pattern.Matches(url))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool ExceptionFilter::TryAcquirePause()
+    {
+        if (m_maxPausesPerSecond == 0)
+        {
+            return true;
+        }
+
+        clock::time_point now = clock::now();
+        if (now - m_windowStart >= std::chrono::seconds(1))
+        {
+            m_windowStart = now;
+            m_pausesInWindow = 0;
+        }
+
+        if (m_pausesInWindow >= m_maxPausesPerSecond)
+        {
+            return false;
+        }
+
+        m_pausesInWindow++;
+        return true;
+    }
+
+    ExceptionFilter::GlobPattern::GlobPattern(const std::string& pattern)
+    {
+        size_t start = 0;
+        size_t star = 0;
+
+        while ((star = pattern.find('*', start)) != std::string::npos)
+        {
+            m_parts.push_back(pattern.substr(start, star - start));
+            start = star + 1;
+        }
+
+        m_parts.push_back(pattern.substr(start));
+    }
+
+    bool ExceptionFilter::GlobPattern::Matches(const std::string& text) const
+    {
+        const std::string& first = m_parts.front();
+
+        if (m_parts.size() == 1)
+        {
+            return text.length() == first.length() && MatchesAt(text, 0, first);
+        }
+
+        const std::string& last = m_parts.back();
+        if (text.length() < first.length() + last.length() ||
+            !MatchesAt(text, 0, first) ||
+            !MatchesAt(text, text.length() - last.length(), last))
+        {
+            return false;
+        }
+
+        // Greedily place each of the middle parts as early as possible between the anchored first and last parts.
+        size_t offset = first.length();
+        size_t end = text.length() - last.length();
+
+        for (size_t i = 1; i < m_parts.size() - 1; i++)
+        {
+            const std::string& part = m_parts[i];
+            bool found = false;
+
+            for (; offset + part.length() <= end; offset++)
+            {
+                if (MatchesAt(text, offset, part))
+                {
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found)
+            {
+                return false;
+            }
+
+            offset += part.length();
+        }
+
+        return true;
+    }
+
+    bool ExceptionFilter::GlobPattern::MatchesAt(const std::string& text, size_t offset, const std::string& part)
+    {
+        for (size_t i = 0; i < part.length(); i++)
+        {
+            if (part[i] != '?' && part[i] != text[offset + i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
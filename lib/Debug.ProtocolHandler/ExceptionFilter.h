@@ -0,0 +1,63 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace JsDebug
+{
+    //
+    // Additional conditions for pausing on exceptions. An exception only causes a pause if its constructor name is in
+    // the type list, it was thrown from a URL matching one of the glob patterns, and the per-second pause cap hasn't
+    // been reached. Empty lists and a zero cap don't restrict anything.
+    //
+    class ExceptionFilter
+    {
+    public:
+        ExceptionFilter();
+        ~ExceptionFilter();
+
+        void SetExceptionTypes(const std::vector<std::string>& types);
+        void SetUrlPatterns(const std::vector<std::string>& patterns);
+        void SetMaxPausesPerSecond(int maxPausesPerSecond);
+        void Clear();
+
+        bool IsEmpty() const;
+        bool NeedsUrl() const;
+
+        bool MatchesType(const std::string& typeName) const;
+        bool MatchesUrl(const std::string& url) const;
+
+        // Counts the pause against the cap, so only call this once the other checks have passed.
+        bool TryAcquirePause();
+
+    private:
+        class GlobPattern
+        {
+        public:
+            explicit GlobPattern(const std::string& pattern);
+            bool Matches(const std::string& text) const;
+
+        private:
+            static bool MatchesAt(const std::string& text, size_t offset, const std::string& part);
+
+            // The pattern split at each '*'; '?' is matched when comparing the parts.
+            std::vector<std::string> m_parts;
+        };
+
+        typedef std::chrono::steady_clock clock;
+
+        std::unordered_set<std::string> m_types;
+        std::vector<GlobPattern> m_urlPatterns;
+
+        int m_maxPausesPerSecond;
+        int m_pausesInWindow;
+        clock::time_point m_windowStart;
+    };
+}
@@ -0,0 +1,99 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "PropertyHelpers.h"
+
+#include <cstring>
+
+namespace JsDebug
+{
+    namespace PropertyHelpers
+    {
+        bool TryGetProperty(JsValueRef object, const char* name, JsValueRef* value)
+        {
+            JsPropertyIdRef propertyId = JS_INVALID_REFERENCE;
+            if (JsCreatePropertyId(name, std::strlen(name), &propertyId) != JsNoError)
+            {
+                return false;
+            }
+
+            bool hasProperty = false;
+            if (JsHasProperty(object, propertyId, &hasProperty) != JsNoError || !hasProperty)
+            {
+                return false;
+            }
+
+            return JsGetProperty(object, propertyId, value) == JsNoError;
+        }
+
+        bool TryGetBool(JsValueRef object, const char* name, bool* value)
+        {
+            JsValueRef property = JS_INVALID_REFERENCE;
+            if (!TryGetProperty(object, name, &property))
+            {
+                return false;
+            }
+
+            return JsBooleanToBool(property, value) == JsNoError;
+        }
+
+        bool TryGetInt(JsValueRef object, const char* name, int* value)
+        {
+            JsValueRef property = JS_INVALID_REFERENCE;
+            if (!TryGetProperty(object, name, &property))
+            {
+                return false;
+            }
+
+            return JsNumberToInt(property, value) == JsNoError;
+        }
+
+        bool TryGetString(JsValueRef object, const char* name, std::string* value)
+        {
+            JsValueRef property = JS_INVALID_REFERENCE;
+            if (!TryGetProperty(object, name, &property))
+            {
+                return false;
+            }
+
+            return TryGetString(property, value);
+        }
+
+        bool TryGetIndexedProperty(JsValueRef object, int index, JsValueRef* value)
+        {
+            JsValueRef indexValue = JS_INVALID_REFERENCE;
+            if (JsIntToNumber(index, &indexValue) != JsNoError)
+            {
+                return false;
+            }
+
+            return JsGetIndexedProperty(object, indexValue, value) == JsNoError;
+        }
+
+        bool TryGetString(JsValueRef value, std::string* result)
+        {
+            JsValueType type = JsUndefined;
+            if (JsGetValueType(value, &type) != JsNoError || type != JsString)
+            {
+                return false;
+            }
+
+            size_t length = 0;
+            if (JsCopyString(value, nullptr, 0, &length) != JsNoError)
+            {
+                return false;
+            }
+
+            result->resize(length);
+            if (length == 0)
+            {
+                return true;
+            }
+
+            return JsCopyString(value, &(*result)[0], length, nullptr) == JsNoError;
+        }
+    }
+}
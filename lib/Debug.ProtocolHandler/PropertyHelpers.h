@@ -0,0 +1,28 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ChakraCore.h>
+
+#include <string>
+
+namespace JsDebug
+{
+    //
+    // Helpers for reading the objects handed out by the JsDiag* APIs. A missing property, or one of the wrong type,
+    // is reported by returning false rather than throwing since most of these properties are optional.
+    //
+    namespace PropertyHelpers
+    {
+        bool TryGetProperty(JsValueRef object, const char* name, JsValueRef* value);
+        bool TryGetBool(JsValueRef object, const char* name, bool* value);
+        bool TryGetInt(JsValueRef object, const char* name, int* value);
+        bool TryGetString(JsValueRef object, const char* name, std::string* value);
+        bool TryGetIndexedProperty(JsValueRef object, int index, JsValueRef* value);
+
+        bool TryGetString(JsValueRef value, std::string* result);
+    }
+}
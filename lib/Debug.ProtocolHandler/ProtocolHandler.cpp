@@ -6,16 +6,186 @@
 #include "stdafx.h"
 #include "ProtocolHandler.h"
 
+#include "PropertyHelpers.h"
+
+#include "Cbor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
 namespace JsDebug
 {
+    namespace
+    {
+        // Limits for the console messages retained while no frontend has the Console/Runtime domains enabled.
+        const size_t kConsoleBufferMaxEntries = 1000;
+        const size_t kConsoleBufferMaxBytes = 1024 * 1024;
+        const size_t kConsoleReplayBatchSize = 100;
+
+        // Per call site rate limit for console messages, and the number of call sites tracked at once.
+        const double kConsoleMessagesPerSecond = 50;
+        const double kConsoleMessageBurstSize = 100;
+        const size_t kConsoleMaxCallSites = 4096;
+
+        // How often a run of repeated console messages is reported while it lasts.
+        const std::chrono::milliseconds kConsoleRepeatReportInterval(1000);
+
+        // Depth limit for captured stack traces, and the size of the pool that interns them.
+        const size_t kMaxStackTraceFrames = 200;
+        const size_t kStackTracePoolMaxFrames = 16 * 1024;
+        const size_t kStackTracePoolMaxStacks = 64 * 1024;
+
+        // Memory budget for async call stacks, which are only recorded while the frontend asks for them.
+        const size_t kAsyncStackMaxBytes = 4 * 1024 * 1024;
+
+        // The buffer messages are converted into is kept between messages unless one makes it grow past this.
+        const size_t kSendBufferMaxRetainedBytes = 1024 * 1024;
+
+        // Command buffers kept for reuse once their command has been dispatched, and the largest one worth keeping.
+        const size_t kMaxSpareCommandBuffers = 64;
+        const size_t kMaxSpareCommandBufferBytes = 64 * 1024;
+
+        double GetTimestamp()
+        {
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        JsDebugStringView ToStringView(const char* str)
+        {
+            return JsDebugStringView{ str, str != nullptr ? std::strlen(str) : 0 };
+        }
+
+        void CheckAscii(const protocol::String& str)
+        {
+            const UChar* chars = str.characters16();
+            size_t len = str.length();
+
+            for (size_t i = 0; i < len; i++)
+            {
+                if ((chars[i] & 0xff) != chars[i])
+                {
+                    throw std::runtime_error("Invalid character");
+                }
+            }
+        }
+
+        void AppendAscii(const UChar* chars, size_t len, std::string* buffer)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                buffer->push_back(static_cast<char>(chars[i]));
+            }
+        }
+
+        // Checks and narrows the string in a single pass, reusing whatever capacity the buffer already has.
+        void AssignAscii(const protocol::String& str, std::string* buffer)
+        {
+            const UChar* chars = str.characters16();
+            size_t len = str.length();
+
+            buffer->resize(len);
+            for (size_t i = 0; i < len; i++)
+            {
+                if ((chars[i] & 0xff) != chars[i])
+                {
+                    throw std::runtime_error("Invalid character");
+                }
+
+                (*buffer)[i] = static_cast<char>(chars[i]);
+            }
+        }
+
+        // A value that is already serialized, and is written into a message as it is. It's only ever serialized, so
+        // nothing looks at it as the object it claims to be.
+        class RawJsonValue : public protocol::Value
+        {
+        public:
+            explicit RawJsonValue(const std::string& json)
+                : Value(TypeObject)
+                , m_json(json)
+            {
+            }
+
+            void writeJSON(protocol::StringBuilder* output) const override
+            {
+                protocol::StringUtil::builderAppend(*output, m_json.data(), m_json.length());
+            }
+
+            std::unique_ptr<protocol::Value> clone() const override
+            {
+                return std::unique_ptr<protocol::Value>(new RawJsonValue(m_json));
+            }
+
+        private:
+            std::string m_json;
+        };
+
+        const char* GetConsoleMessageLevel(JsDebugConsoleAPIType type)
+        {
+            using LevelEnum = protocol::Console::ConsoleMessage::LevelEnum;
+
+            switch (type)
+            {
+            case JsDebugConsoleAPITypeDebug:
+                return LevelEnum::Debug;
+            case JsDebugConsoleAPITypeInfo:
+                return LevelEnum::Info;
+            case JsDebugConsoleAPITypeError:
+                return LevelEnum::Error;
+            case JsDebugConsoleAPITypeWarning:
+                return LevelEnum::Warning;
+            default:
+                return LevelEnum::Log;
+            }
+        }
+
+        const char* GetConsoleAPICalledType(JsDebugConsoleAPIType type)
+        {
+            namespace TypeEnum = protocol::Runtime::ConsoleAPICalled::TypeEnum;
+
+            switch (type)
+            {
+            case JsDebugConsoleAPITypeDebug:
+                return TypeEnum::Debug;
+            case JsDebugConsoleAPITypeInfo:
+                return TypeEnum::Info;
+            case JsDebugConsoleAPITypeError:
+                return TypeEnum::Error;
+            case JsDebugConsoleAPITypeWarning:
+                return TypeEnum::Warning;
+            default:
+                return TypeEnum::Log;
+            }
+        }
+    }
+
     ProtocolHandler::ProtocolHandler(JsRuntimeHandle runtime)
         : m_callback(nullptr)
         , m_callbackState(nullptr)
+        , m_flushCallback(nullptr)
+        , m_fragmentCallback(nullptr)
+        , m_fragmentSize(0)
+        , m_resumeRequested(false)
         , m_waitingForDebugger(false)
+        , m_consoleMessages(kConsoleBufferMaxEntries, kConsoleBufferMaxBytes)
+        , m_consoleThrottle(
+            kConsoleMessagesPerSecond,
+            kConsoleMessageBurstSize,
+            kConsoleMaxCallSites,
+            kConsoleRepeatReportInterval)
+        , m_stackTraces(kStackTracePoolMaxFrames, kStackTracePoolMaxStacks)
+        , m_lastExceptionId(0)
+        , m_asyncStacks(kAsyncStackMaxBytes)
         , m_dispatcher(this)
     {
         m_debugger = std::make_unique<Debugger>(runtime);
         m_debugger->SetMessageHandler(&ProtocolHandler::DebuggerMessageHandler, this);
+        m_debugger->SetDebugEventHandler(&ProtocolHandler::DebugEventHandler, this);
+        m_debugger->SetBreakHandler(&ProtocolHandler::DebuggerBreakHandler, this);
+        m_debugger->SetScriptHandler(&ProtocolHandler::DebuggerScriptHandler, this);
+        m_debugger->SetBreakpointHandler(&ProtocolHandler::DebuggerBreakpointHandler, this);
 
         m_consoleAgent = std::make_unique<ConsoleImpl>(this);
         protocol::Console::Dispatcher::wire(&m_dispatcher, m_consoleAgent.get());
@@ -39,6 +209,8 @@ namespace JsDebug
         ProtocolHandlerSendResponseCallback callback,
         void* callbackState)
     {
+        std::unique_lock<std::recursive_mutex> lock(m_callbackLock);
+
         if (m_callback != nullptr)
         {
             throw std::runtime_error("Handler is already connected");
@@ -48,10 +220,42 @@ namespace JsDebug
         m_callbackState = callbackState;
     }
 
+    void ProtocolHandler::SetFlushCallback(ProtocolHandlerFlushCallback callback)
+    {
+        std::unique_lock<std::recursive_mutex> lock(m_callbackLock);
+        m_flushCallback = callback;
+    }
+
+    void ProtocolHandler::SetFragmentCallback(ProtocolHandlerSendFragmentCallback callback, size_t fragmentSize)
+    {
+        std::unique_lock<std::recursive_mutex> lock(m_callbackLock);
+        m_fragmentCallback = callback;
+        m_fragmentSize = fragmentSize;
+    }
+
+    void ProtocolHandler::SetMaxSourceMapFileSize(size_t maxFileSize)
+    {
+        m_debugger->SetMaxSourceMapFileSize(maxFileSize);
+    }
+
     void ProtocolHandler::Disconnect()
     {
-        m_callback = nullptr;
-        m_callbackState = nullptr;
+        {
+            std::unique_lock<std::recursive_mutex> lock(m_callbackLock);
+            m_callback = nullptr;
+            m_callbackState = nullptr;
+            m_flushCallback = nullptr;
+            m_fragmentCallback = nullptr;
+        }
+
+        // Nobody is left to resume a paused engine, so have the script thread let it go. Stepping state belongs to
+        // that thread, so it isn't touched from here.
+        if (m_debugger->IsPaused())
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_resumeRequested = true;
+            m_commandWaiting.notify_all();
+        }
     }
 
     void ProtocolHandler::SendCommand(const char* command)
@@ -62,12 +266,39 @@ namespace JsDebug
         OutputDebugStringA("},\r\n");
 #endif
 
+        QueueCommand(command, std::strlen(command), false);
+    }
+
+    void ProtocolHandler::SendCborCommand(const uint8_t* command, size_t length)
+    {
+        QueueCommand(reinterpret_cast<const char*>(command), length, true);
+    }
+
+    void ProtocolHandler::QueueCommand(const char* command, size_t length, bool cbor)
+    {
+        // Pipelined commands are mostly small, so a buffer from one that has already been dispatched usually fits
+        // without going back to the heap.
+        Command entry = { std::string(), cbor };
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            if (!m_spareCommandBuffers.empty())
+            {
+                entry.payload.swap(m_spareCommandBuffers.back());
+                m_spareCommandBuffers.pop_back();
+            }
+        }
+
+        entry.payload.assign(command, length);
+
         {
             std::unique_lock<std::mutex> lock(m_lock);
-            m_commandQueue.emplace_back(command);
+            m_commandQueue.push_back(std::move(entry));
             m_commandWaiting.notify_all();
         }
 
+        // Always ask for a break, even while paused: the engine could resume between checking and queuing, which
+        // would leave the command sitting in the queue. A break that finds the queue already empty costs nothing.
         m_debugger->RequestAsyncBreak();
     }
 
@@ -86,33 +317,230 @@ namespace JsDebug
         m_waitingForDebugger = false;
     }
 
-    void ProtocolHandler::sendProtocolResponse(int callId, std::unique_ptr<Serializable> message)
+    void ProtocolHandler::ConsoleAPICalled(
+        JsDebugConsoleAPIType type,
+        const char* text,
+        const char* url,
+        int lineNumber,
+        int columnNumber)
     {
-        sendProtocolNotification(std::move(message));
+        if (m_consoleThrottle.IsRepeat(type, text, url, lineNumber, columnNumber))
+        {
+            if (m_consoleThrottle.IsRepeatReportDue())
+            {
+                FlushConsoleRepeats();
+            }
+
+            return;
+        }
+
+        FlushConsoleRepeats();
+
+        uint32_t suppressedCount = 0;
+        if (!m_consoleThrottle.TryAcquire(url, lineNumber, columnNumber, &suppressedCount))
+        {
+            return;
+        }
+
+        if (suppressedCount > 0)
+        {
+            std::string notice = std::to_string(suppressedCount) + " messages from this location were suppressed";
+            RecordConsoleMessage(JsDebugConsoleAPITypeWarning, notice.c_str(), url, lineNumber, columnNumber);
+        }
+
+        RecordConsoleMessage(type, text, url, lineNumber, columnNumber);
+        m_consoleThrottle.SetLastMessage(type, text, url, lineNumber, columnNumber);
     }
 
-    void ProtocolHandler::sendProtocolNotification(std::unique_ptr<Serializable> message)
+    void ProtocolHandler::ReplayConsoleMessages(ConsoleMessageKind kind)
     {
-        protocol::String str = message->serialize();
+        FlushConsoleRepeats();
 
-        const UChar* chars = str.characters16();
-        size_t len = str.length();
-        std::vector<char> buffer;
-        buffer.reserve(len + 1);
+        JsDebugConsoleMessageEvent message = {};
 
-        for (size_t i = 0; i < len; i++)
+        for (size_t i = 0; m_consoleMessages.GetEntry(i, &message); i++)
         {
-            if ((chars[i] & 0xff) != chars[i])
+            SendConsoleMessage(kind, message);
+
+            if ((i + 1) % kConsoleReplayBatchSize == 0)
             {
-                throw std::runtime_error("Invalid character");
+                flushProtocolNotifications();
             }
+        }
 
-            buffer.push_back(static_cast<char>(chars[i]));
+        flushProtocolNotifications();
+    }
+
+    void ProtocolHandler::ClearConsoleMessages()
+    {
+        m_consoleMessages.Clear();
+        m_consoleThrottle.ClearLastMessage();
+    }
+
+    void ProtocolHandler::AsyncTaskScheduled(
+        const void* task,
+        const char* description,
+        const char* url,
+        int lineNumber,
+        int columnNumber)
+    {
+        m_asyncStacks.TaskScheduled(task, description, url, lineNumber, columnNumber);
+    }
+
+    void ProtocolHandler::AsyncTaskStarted(const void* task)
+    {
+        m_asyncStacks.TaskStarted(task);
+    }
+
+    void ProtocolHandler::AsyncTaskFinished(const void* task)
+    {
+        m_asyncStacks.TaskFinished(task);
+    }
+
+    void ProtocolHandler::SetAsyncCallStackDepth(int maxDepth)
+    {
+        m_asyncStacks.SetMaxDepth(maxDepth);
+    }
+
+    JsDebugEventListener ProtocolHandler::AddEventListener(
+        unsigned int eventTypes,
+        JsDebugEventCallback callback,
+        void* callbackState)
+    {
+        return m_eventListeners.Add(eventTypes, callback, callbackState);
+    }
+
+    bool ProtocolHandler::RemoveEventListener(JsDebugEventListener listener)
+    {
+        return m_eventListeners.Remove(listener);
+    }
+
+    void ProtocolHandler::RecordConsoleMessage(
+        JsDebugConsoleAPIType type,
+        const char* text,
+        const char* url,
+        int lineNumber,
+        int columnNumber)
+    {
+        // Native listeners get the message as it is. The protocol messages are only built for domains that are
+        // enabled now, or when one is enabled later and the buffered message is replayed.
+        JsDebugConsoleMessageEvent event = {
+            type,
+            ToStringView(text),
+            ToStringView(url),
+            lineNumber,
+            columnNumber,
+            GetTimestamp() };
+
+        m_eventListeners.PublishConsoleMessage(event);
+        m_consoleMessages.Add(event);
+
+        bool sent = false;
+
+        if (m_consoleAgent->IsEnabled())
+        {
+            SendConsoleMessage(ConsoleMessageKind::MessageAdded, event);
+            sent = true;
+        }
+
+        if (m_runtimeAgent->IsEnabled())
+        {
+            SendConsoleMessage(ConsoleMessageKind::ConsoleAPICalled, event);
+            sent = true;
         }
 
-        buffer.push_back('\0');
+        if (sent)
+        {
+            flushProtocolNotifications();
+        }
+    }
 
-        const char* response = buffer.data();
+    void ProtocolHandler::SendConsoleMessage(ConsoleMessageKind kind, const JsDebugConsoleMessageEvent& event)
+    {
+        String16 messageText = String16::fromUTF8(event.text.data, event.text.length);
+        String16 messageUrl = event.url.length != 0
+            ? String16::fromUTF8(event.url.data, event.url.length)
+            : String16();
+
+        if (kind == ConsoleMessageKind::MessageAdded)
+        {
+            std::unique_ptr<protocol::Console::ConsoleMessage> message = protocol::Console::ConsoleMessage::create()
+                .setSource(protocol::Console::ConsoleMessage::SourceEnum::ConsoleApi)
+                .setLevel(GetConsoleMessageLevel(event.type))
+                .setText(messageText)
+                .build();
+
+            if (!messageUrl.empty())
+            {
+                message->setUrl(messageUrl);
+            }
+
+            if (event.lineNumber > 0)
+            {
+                message->setLine(event.lineNumber);
+            }
+
+            if (event.columnNumber > 0)
+            {
+                message->setColumn(event.columnNumber);
+            }
+
+            protocol::Console::Frontend(this).messageAdded(std::move(message));
+            return;
+        }
+
+        auto args = protocol::Array<protocol::Runtime::RemoteObject>::create();
+        args->addItem(protocol::Runtime::RemoteObject::create()
+            .setType(protocol::Runtime::RemoteObject::TypeEnum::String)
+            .setValue(protocol::StringValue::create(messageText))
+            .build());
+
+        protocol::Maybe<protocol::Runtime::StackTrace> stackTrace;
+        if (!messageUrl.empty())
+        {
+            // Runtime.consoleAPICalled locations are 0-based and only carried by the stack trace.
+            auto callFrames = protocol::Array<protocol::Runtime::CallFrame>::create();
+            callFrames->addItem(protocol::Runtime::CallFrame::create()
+                .setFunctionName(String16())
+                .setScriptId(String16())
+                .setUrl(messageUrl)
+                .setLineNumber(event.lineNumber > 0 ? event.lineNumber - 1 : 0)
+                .setColumnNumber(event.columnNumber > 0 ? event.columnNumber - 1 : 0)
+                .build());
+
+            stackTrace = protocol::Runtime::StackTrace::create()
+                .setCallFrames(std::move(callFrames))
+                .build();
+        }
+
+        protocol::Runtime::Frontend(this).consoleAPICalled(
+            GetConsoleAPICalledType(event.type),
+            std::move(args),
+            kExecutionContextId,
+            event.timestamp,
+            std::move(stackTrace));
+    }
+
+    void ProtocolHandler::sendProtocolResponse(int callId, std::unique_ptr<Serializable> message)
+    {
+        sendProtocolNotification(std::move(message));
+    }
+
+    void ProtocolHandler::sendProtocolNotification(std::unique_ptr<Serializable> message)
+    {
+        protocol::String serialized = message->serialize();
+
+        // The message can hold something as large as a script's source, so it goes before another copy is made.
+        message.reset();
+
+        if (m_fragmentCallback != nullptr && serialized.length() > m_fragmentSize)
+        {
+            SendFragmented(serialized);
+            return;
+        }
+
+        AssignAscii(serialized, &m_sendBuffer);
+        const char* response = m_sendBuffer.c_str();
 
 #ifdef _DEBUG
         OutputDebugStringA("{\"type\":\"response\",\"payload\":");
@@ -121,10 +549,21 @@ namespace JsDebug
 #endif
 
         SendResponse(response);
+
+        if (m_sendBuffer.capacity() > kSendBufferMaxRetainedBytes)
+        {
+            std::string().swap(m_sendBuffer);
+        }
     }
 
     void ProtocolHandler::flushProtocolNotifications()
     {
+        std::unique_lock<std::recursive_mutex> lock(m_callbackLock);
+
+        if (m_callback != nullptr && m_flushCallback != nullptr)
+        {
+            m_flushCallback(m_callbackState);
+        }
     }
 
     void ProtocolHandler::DebuggerMessageHandler(void* callbackState)
@@ -133,34 +572,273 @@ namespace JsDebug
         handler->ProcessQueue(false);
     }
 
+    void ProtocolHandler::DebuggerBreakHandler(const BreakInfo& breakInfo, void* callbackState)
+    {
+        auto handler = static_cast<ProtocolHandler*>(callbackState);
+        handler->HandleBreak(breakInfo);
+    }
+
+    void ProtocolHandler::DebuggerScriptHandler(const ScriptInfo& script, void* callbackState)
+    {
+        auto handler = static_cast<ProtocolHandler*>(callbackState);
+
+        handler->m_eventListeners.PublishScriptParsed(script);
+
+        if (handler->m_callback != nullptr && handler->m_debuggerAgent->IsEnabled())
+        {
+            handler->m_debuggerAgent->SendScriptParsed(script);
+            handler->flushProtocolNotifications();
+        }
+    }
+
+    void ProtocolHandler::DebuggerBreakpointHandler(
+        int breakpointId,
+        const SourceLocation& location,
+        void* callbackState)
+    {
+        auto handler = static_cast<ProtocolHandler*>(callbackState);
+
+        if (handler->m_callback != nullptr)
+        {
+            handler->m_debuggerAgent->SendBreakpointResolved(breakpointId, location);
+        }
+    }
+
+    void ProtocolHandler::HandleBreak(const BreakInfo& breakInfo)
+    {
+        bool listening = m_eventListeners.IsListening(JsDebugEventTypePaused);
+        if (m_callback == nullptr && !listening)
+        {
+            return;
+        }
+
+        // Walking the stack is the expensive part, so it's done once for both the frontend and native listeners.
+        std::vector<CallFrameInfo> callFrames = m_debugger->GetCallFrames();
+        m_eventListeners.PublishPaused(breakInfo, callFrames);
+
+        // Without a frontend there is nobody to resume the engine, so native listeners only get to look.
+        if (m_callback != nullptr)
+        {
+            m_debuggerAgent->SendPausedEvent(breakInfo, callFrames, m_asyncStacks.GetCurrentStackTrace());
+
+            while (m_debugger->IsPaused())
+            {
+                ProcessQueue(true);
+            }
+
+            m_debuggerAgent->SendResumedEvent();
+        }
+
+        m_eventListeners.PublishResumed();
+    }
+
+    void ProtocolHandler::DebugEventHandler(JsDiagDebugEvent debugEvent, JsValueRef eventData, void* callbackState)
+    {
+        auto handler = static_cast<ProtocolHandler*>(callbackState);
+
+        // Pending repeats go out ahead of whatever the event leads to, such as a new script or an exception.
+        handler->FlushConsoleRepeats();
+
+        if (debugEvent == JsDiagDebugEventRuntimeException)
+        {
+            handler->ReportException(eventData);
+        }
+    }
+
+    void ProtocolHandler::ReportException(JsValueRef eventData)
+    {
+        ExceptionInfo info = {};
+        PropertyHelpers::TryGetBool(eventData, "uncaught", &info.uncaught);
+
+        bool report = m_runtimeAgent->IsEnabled() && info.uncaught;
+        if (!report && !m_eventListeners.IsListening(JsDebugEventTypeException))
+        {
+            return;
+        }
+
+        JsValueRef exception = JS_INVALID_REFERENCE;
+
+        PropertyHelpers::TryGetInt(eventData, "scriptId", &info.scriptId);
+        PropertyHelpers::TryGetInt(eventData, "line", &info.line);
+        PropertyHelpers::TryGetInt(eventData, "column", &info.column);
+
+        if (PropertyHelpers::TryGetProperty(eventData, "exception", &exception))
+        {
+            PropertyHelpers::TryGetString(exception, "display", &info.text);
+        }
+
+        double timestamp = GetTimestamp();
+        m_eventListeners.PublishException(info, timestamp);
+
+        if (!report)
+        {
+            return;
+        }
+
+        std::string text = "Uncaught " + info.text;
+
+        std::unique_ptr<protocol::DictionaryValue> details = protocol::Runtime::ExceptionDetails::create()
+            .setExceptionId(++m_lastExceptionId)
+            .setText(String16::fromUTF8(text.c_str(), text.length()))
+            .setLineNumber(info.line)
+            .setColumnNumber(info.column)
+            .setScriptId(String16(std::to_string(info.scriptId).c_str()))
+            .setExecutionContextId(kExecutionContextId)
+            .build()
+            ->toValue();
+
+        // An error storm tends to throw from the same few stacks, so the pool only resolves each frame once and keeps
+        // the stack trace serialized, and that goes into the message as it is. The notification is put together here
+        // since the generated frontend only takes a StackTrace object.
+        uint32_t stackId = m_debugger->CaptureStackTrace(&m_stackTraces, kMaxStackTraceFrames);
+        details->setValue(
+            "stackTrace",
+            std::unique_ptr<protocol::Value>(new RawJsonValue(m_stackTraces.GetSerializedStackTrace(stackId))));
+
+        std::unique_ptr<protocol::DictionaryValue> params = protocol::DictionaryValue::create();
+        params->setDouble("timestamp", timestamp);
+        params->setObject("exceptionDetails", std::move(details));
+
+        std::unique_ptr<protocol::DictionaryValue> notification = protocol::DictionaryValue::create();
+        notification->setString("method", "Runtime.exceptionThrown");
+        notification->setObject("params", std::move(params));
+
+        sendProtocolNotification(std::move(notification));
+        flushProtocolNotifications();
+    }
+
     void ProtocolHandler::ProcessQueue(bool waitForCommands)
     {
-        std::vector<std::string> current;
+        // This runs whenever the debugger gets control, so it doubles as the point where a pending run of repeated
+        // console messages gets reported: before a pause is handled, and again after the commands in the batch have
+        // run, since those can log too.
+        FlushConsoleRepeats();
+
+        // The batch is swapped with the (empty) one from last time, so neither side has to grow its vector again.
+        std::vector<Command> current;
+        std::swap(m_dispatching, current);
+
+        bool resume = false;
 
         {
             std::unique_lock<std::mutex> lock(m_lock);
 
-            if (waitForCommands && m_commandQueue.empty())
+            // Disconnect requests the resume under the lock, so checking here can't miss that wakeup.
+            if (waitForCommands && m_commandQueue.empty() && !m_resumeRequested &&
+                (m_waitingForDebugger || m_debugger->IsPaused()))
             {
                 m_commandWaiting.wait(lock);
             }
 
             std::swap(m_commandQueue, current);
+            std::swap(m_resumeRequested, resume);
         }
 
         for (const auto& command : current)
         {
-            m_dispatcher.dispatch(protocol::parseJSONCharacters(
-                reinterpret_cast<const uint8_t*>(command.c_str()),
-                static_cast<unsigned int>(command.length())));
+            const uint8_t* payload = reinterpret_cast<const uint8_t*>(command.payload.c_str());
+
+            m_dispatcher.dispatch(command.cbor
+                ? Cbor::Parse(payload, command.payload.length())
+                : protocol::parseJSONCharacters(payload, static_cast<unsigned int>(command.payload.length())));
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            for (auto& command : current)
+            {
+                if (m_spareCommandBuffers.size() < kMaxSpareCommandBuffers &&
+                    command.payload.capacity() <= kMaxSpareCommandBufferBytes)
+                {
+                    m_spareCommandBuffers.push_back(std::move(command.payload));
+                }
+            }
         }
+
+        current.clear();
+        std::swap(m_dispatching, current);
+
+        FlushConsoleRepeats();
+
+        // Anything the frontend sent before it went away has been handled by now.
+        if (resume)
+        {
+            m_debugger->Resume();
+        }
+
+        // Everything sent while handling this batch of commands, including any console repeats, goes out together.
+        flushProtocolNotifications();
     }
 
     void ProtocolHandler::SendResponse(const char* response)
     {
+        std::unique_lock<std::recursive_mutex> lock(m_callbackLock);
+
         if (m_callback != nullptr)
         {
             m_callback(response, m_callbackState);
         }
     }
+
+    void ProtocolHandler::SendFragmented(const protocol::String& response)
+    {
+        // Check the whole response up front so that it can't fail halfway through.
+        CheckAscii(response);
+
+        // The lock is held for the whole message, so a disconnect from another thread waits for its last fragment.
+        std::unique_lock<std::recursive_mutex> lock(m_callbackLock);
+
+        if (m_callback == nullptr || m_fragmentCallback == nullptr)
+        {
+            return;
+        }
+
+        const UChar* chars = response.characters16();
+        size_t length = response.length();
+
+        // Fragments are built in the same buffer whole messages are.
+        std::string& fragment = m_sendBuffer;
+
+#ifdef _DEBUG
+        OutputDebugStringA("{\"type\":\"response\",\"payload\":");
+#endif
+
+        for (size_t offset = 0; offset < length && m_fragmentCallback != nullptr; offset += m_fragmentSize)
+        {
+            size_t count = (std::min)(m_fragmentSize, length - offset);
+
+            fragment.clear();
+            AppendAscii(chars + offset, count, &fragment);
+
+#ifdef _DEBUG
+            OutputDebugStringA(fragment.c_str());
+#endif
+
+            m_fragmentCallback(fragment.c_str(), fragment.length(), offset + count == length, m_callbackState);
+        }
+
+#ifdef _DEBUG
+        OutputDebugStringA("},\r\n");
+#endif
+    }
+
+    void ProtocolHandler::FlushConsoleRepeats()
+    {
+        uint32_t repeatCount = m_consoleThrottle.TakeRepeatCount();
+        if (repeatCount == 0)
+        {
+            return;
+        }
+
+        const ConsoleMessageInfo& last = m_consoleThrottle.GetLastMessage();
+        std::string notice = "Previous message repeated " + std::to_string(repeatCount) + " more times";
+
+        RecordConsoleMessage(
+            last.type,
+            notice.c_str(),
+            last.url.empty() ? nullptr : last.url.c_str(),
+            last.lineNumber,
+            last.columnNumber);
+    }
 }
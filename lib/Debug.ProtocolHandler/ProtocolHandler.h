@@ -5,7 +5,13 @@
 
 #pragma once
 
+#include "AsyncStackTracker.h"
+#include "ChakraDebugProtocolHandler.h"
+#include "ConsoleMessageBuffer.h"
+#include "ConsoleMessageThrottle.h"
 #include "Debugger.h"
+#include "EventListeners.h"
+#include "StackTracePool.h"
 
 #include "protocol\Forward.h"
 #include "protocol\Protocol.h"
@@ -26,39 +32,130 @@ namespace JsDebug
     using protocol::Serializable;
 
     typedef void(CHAKRA_CALLBACK* ProtocolHandlerSendResponseCallback)(const char* response, void* callbackState);
+    typedef void(CHAKRA_CALLBACK* ProtocolHandlerFlushCallback)(void* callbackState);
+    typedef void(CHAKRA_CALLBACK* ProtocolHandlerSendFragmentCallback)(
+        const char* fragment,
+        size_t length,
+        bool final,
+        void* callbackState);
 
     class ProtocolHandler : public protocol::FrontendChannel
     {
     public:
+        // There is no support for multiple execution contexts, so report everything against a single one.
+        static const int kExecutionContextId = 1;
+
         ProtocolHandler(JsRuntimeHandle runtime);
         ~ProtocolHandler() override;
 
         void Connect(bool breakOnNextLine, ProtocolHandlerSendResponseCallback callback, void* callbackState);
+        void SetFlushCallback(ProtocolHandlerFlushCallback callback);
+        void SetFragmentCallback(ProtocolHandlerSendFragmentCallback callback, size_t fragmentSize);
+        void SetMaxSourceMapFileSize(size_t maxFileSize);
         void Disconnect();
 
         void SendCommand(const char* command);
+        void SendCborCommand(const uint8_t* command, size_t length);
         void WaitForDebugger();
         void RunIfWaitingForDebugger();
 
+        void ConsoleAPICalled(
+            JsDebugConsoleAPIType type,
+            const char* text,
+            const char* url,
+            int lineNumber,
+            int columnNumber);
+        void ReplayConsoleMessages(ConsoleMessageKind kind);
+        void ClearConsoleMessages();
+
+        void AsyncTaskScheduled(
+            const void* task,
+            const char* description,
+            const char* url,
+            int lineNumber,
+            int columnNumber);
+        void AsyncTaskStarted(const void* task);
+        void AsyncTaskFinished(const void* task);
+        void SetAsyncCallStackDepth(int maxDepth);
+
+        JsDebugEventListener AddEventListener(
+            unsigned int eventTypes,
+            JsDebugEventCallback callback,
+            void* callbackState);
+        bool RemoveEventListener(JsDebugEventListener listener);
+
         // protocol::FrontendChannel implementation
         void sendProtocolResponse(int callId, std::unique_ptr<Serializable> message) override;
         void sendProtocolNotification(std::unique_ptr<Serializable> message) override;
         void flushProtocolNotifications() override;
 
     private:
+        struct Command
+        {
+            std::string payload;
+            bool cbor;
+        };
+
         static void DebuggerMessageHandler(void* callbackState);
+        static void DebuggerBreakHandler(const BreakInfo& breakInfo, void* callbackState);
+        static void DebuggerScriptHandler(const ScriptInfo& script, void* callbackState);
+        static void DebuggerBreakpointHandler(int breakpointId, const SourceLocation& location, void* callbackState);
+        static void CHAKRA_CALLBACK DebugEventHandler(
+            JsDiagDebugEvent debugEvent,
+            JsValueRef eventData,
+            void* callbackState);
+        void ReportException(JsValueRef eventData);
+        void HandleBreak(const BreakInfo& breakInfo);
+        void QueueCommand(const char* command, size_t length, bool cbor);
         void ProcessQueue(bool waitForCommands);
         void SendResponse(const char* response);
+        void SendFragmented(const protocol::String& response);
+        void RecordConsoleMessage(
+            JsDebugConsoleAPIType type,
+            const char* text,
+            const char* url,
+            int lineNumber,
+            int columnNumber);
+        void FlushConsoleRepeats();
+        void SendConsoleMessage(ConsoleMessageKind kind, const JsDebugConsoleMessageEvent& event);
 
         std::unique_ptr<Debugger> m_debugger;
+
+        // Held by the script thread while it calls the frontend's callbacks, and while they're changed, so that
+        // Disconnect waits for a send in progress and the frontend's state is never used once it returns. Recursive
+        // since a host can disconnect from within a callback.
+        std::recursive_mutex m_callbackLock;
         ProtocolHandlerSendResponseCallback m_callback;
         void* m_callbackState;
+        ProtocolHandlerFlushCallback m_flushCallback;
+        ProtocolHandlerSendFragmentCallback m_fragmentCallback;
+        size_t m_fragmentSize;
+
+        // Serialized messages are narrowed into this before they're sent. Only used on the script thread.
+        std::string m_sendBuffer;
 
         std::mutex m_lock;
         std::condition_variable m_commandWaiting;
-        std::vector<std::string> m_commandQueue;
+        std::vector<Command> m_commandQueue;
+        std::vector<std::string> m_spareCommandBuffers;
+
+        // Set by Disconnect so that the script thread resumes the engine the next time it gets control.
+        bool m_resumeRequested;
+
+        // The batch of commands being dispatched. Only used on the script thread.
+        std::vector<Command> m_dispatching;
         bool m_waitingForDebugger;
 
+        ConsoleMessageBuffer m_consoleMessages;
+        ConsoleMessageThrottle m_consoleThrottle;
+
+        StackTracePool m_stackTraces;
+        int m_lastExceptionId;
+
+        AsyncStackTracker m_asyncStacks;
+
+        EventListeners m_eventListeners;
+
         protocol::UberDispatcher m_dispatcher;
         std::unique_ptr<ConsoleImpl> m_consoleAgent;
         std::unique_ptr<DebuggerImpl> m_debuggerAgent;
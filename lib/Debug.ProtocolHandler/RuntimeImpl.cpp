@@ -11,6 +11,7 @@ namespace JsDebug
 {
     RuntimeImpl::RuntimeImpl(ProtocolHandler* handler)
         : m_handler(handler)
+        , m_enabled(false)
     {
     }
 
@@ -18,6 +19,11 @@ namespace JsDebug
     {
     }
 
+    bool RuntimeImpl::IsEnabled() const
+    {
+        return m_enabled;
+    }
+
     void RuntimeImpl::evaluate(
         const String & in_expression,
         Maybe<String> in_objectGroup,
@@ -83,17 +89,27 @@ namespace JsDebug
 
     Response RuntimeImpl::enable()
     {
-        return Response();
+        if (m_enabled)
+        {
+            return Response::OK();
+        }
+
+        m_enabled = true;
+        m_handler->ReplayConsoleMessages(ConsoleMessageKind::ConsoleAPICalled);
+
+        return Response::OK();
     }
 
     Response RuntimeImpl::disable()
     {
-        return Response();
+        m_enabled = false;
+        return Response::OK();
     }
 
     Response RuntimeImpl::discardConsoleEntries()
     {
-        return Response();
+        m_handler->ClearConsoleMessages();
+        return Response::OK();
     }
 
     Response RuntimeImpl::setCustomObjectFormatterEnabled(bool in_enabled)
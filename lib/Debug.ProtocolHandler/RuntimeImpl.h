@@ -22,6 +22,8 @@ namespace JsDebug
         RuntimeImpl(ProtocolHandler* handler);
         ~RuntimeImpl() override;
 
+        bool IsEnabled() const;
+
         // protocol::Runtime::Backend implementation
         void evaluate(
             const String& in_expression,
@@ -84,5 +86,6 @@ namespace JsDebug
 
     private:
         ProtocolHandler* m_handler;
+        bool m_enabled;
     };
 }
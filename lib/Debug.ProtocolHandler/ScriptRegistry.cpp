@@ -0,0 +1,343 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "ScriptRegistry.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sys/stat.h>
+
+namespace JsDebug
+{
+    namespace
+    {
+        const int kFirstOriginalSourceId = 0x40000000;
+
+        const char kDataUrlPrefix[] = "data:";
+        const char kFileUrlPrefix[] = "file://";
+        const char kLocalHost[] = "localhost";
+
+        bool StartsWith(const std::string& str, const char* prefix)
+        {
+            return str.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+        }
+
+        // True for anything with a URL scheme. Single letter "schemes" are Windows drive letters.
+        bool HasScheme(const std::string& url)
+        {
+            size_t colon = url.find(':');
+            if (colon == std::string::npos || colon < 2)
+            {
+                return false;
+            }
+
+            return std::all_of(url.begin(), url.begin() + colon, [](char c)
+            {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '+' || c == '-' || c == '.';
+            });
+        }
+
+        bool IsAbsolute(const std::string& url)
+        {
+            return HasScheme(url) ||
+                StartsWith(url, "/") ||
+                StartsWith(url, "\\") ||
+                (url.length() > 2 && url[1] == ':' && (url[2] == '\\' || url[2] == '/'));
+        }
+
+        std::string Resolve(const std::string& base, const std::string& relative)
+        {
+            if (IsAbsolute(relative))
+            {
+                return relative;
+            }
+
+            size_t slash = base.find_last_of("/\\");
+            return slash == std::string::npos ? relative : base.substr(0, slash + 1) + relative;
+        }
+
+        // Network shares (\\host\share), the Win32 device namespace (\\.\ and \\?\) and /dev are never read, since
+        // opening them can block the script thread or reach out to another machine.
+        bool IsRemoteOrDevicePath(const std::string& path)
+        {
+            return StartsWith(path, "\\\\") ||
+                StartsWith(path, "//") ||
+                StartsWith(path, "\\/") ||
+                StartsWith(path, "/\\") ||
+                StartsWith(path, "/dev/");
+        }
+
+        // Only regular files are read, and no more than maxSize bytes of them.
+        bool ReadLocalFile(const std::string& path, size_t maxSize, std::string* contents)
+        {
+            if (IsRemoteOrDevicePath(path))
+            {
+                return false;
+            }
+
+            struct stat status;
+            if (stat(path.c_str(), &status) != 0 ||
+                (status.st_mode & S_IFMT) != S_IFREG ||
+                static_cast<unsigned long long>(status.st_size) > maxSize)
+            {
+                return false;
+            }
+
+            std::ifstream file(path, std::ios::in | std::ios::binary);
+            if (!file)
+            {
+                return false;
+            }
+
+            // The file may have changed since it was checked, so don't trust the size.
+            contents->resize(maxSize + 1);
+            file.read(&(*contents)[0], static_cast<std::streamsize>(contents->size()));
+
+            size_t length = static_cast<size_t>(file.gcount());
+            if (length > maxSize)
+            {
+                return false;
+            }
+
+            contents->resize(length);
+            return true;
+        }
+
+        int CountLines(const std::string& text)
+        {
+            return static_cast<int>(std::count(text.begin(), text.end(), '\n'));
+        }
+    }
+
+    ScriptRegistry::ScriptRegistry()
+        : m_nextOriginalSourceId(kFirstOriginalSourceId)
+        , m_maxSourceMapFileSize(0)
+    {
+    }
+
+    ScriptRegistry::~ScriptRegistry()
+    {
+    }
+
+    void ScriptRegistry::AddScript(
+        int scriptId,
+        const std::string& url,
+        int lineCount,
+        const std::string& sourceMapUrl,
+        std::vector<int>* addedIds)
+    {
+        if (m_scripts.find(scriptId) != m_scripts.end())
+        {
+            return;
+        }
+
+        ScriptInfo script = { scriptId, url, lineCount > 0 ? lineCount - 1 : 0, 0, std::string(), -1, 0 };
+
+        std::string mapLocation;
+        std::shared_ptr<SourceMap> sourceMap;
+        if (!sourceMapUrl.empty())
+        {
+            sourceMap = LoadSourceMap(sourceMapUrl, url, &mapLocation);
+            if (sourceMap == nullptr)
+            {
+                script.sourceMapUrl = sourceMapUrl;
+            }
+        }
+
+        Insert(std::move(script));
+        addedIds->push_back(scriptId);
+
+        if (sourceMap == nullptr)
+        {
+            return;
+        }
+
+        int firstSourceId = m_nextOriginalSourceId;
+
+        for (uint32_t i = 0; i < sourceMap->SourceCount(); i++)
+        {
+            const std::string* content = nullptr;
+            int endLine = sourceMap->TryGetSourceContent(i, &content) ? CountLines(*content) : 0;
+
+            int id = m_nextOriginalSourceId++;
+            std::string sourceUrl = Resolve(mapLocation, sourceMap->GetSource(i));
+
+            Insert(ScriptInfo{ id, std::move(sourceUrl), endLine, 0, std::string(), scriptId, i });
+            addedIds->push_back(id);
+        }
+
+        m_sourceMaps.emplace(scriptId, LoadedSourceMap{ std::move(sourceMap), firstSourceId });
+    }
+
+    const ScriptInfo* ScriptRegistry::Find(int scriptId) const
+    {
+        auto it = m_scripts.find(scriptId);
+        return it != m_scripts.end() ? &it->second : nullptr;
+    }
+
+    std::vector<int> ScriptRegistry::FindByUrl(const std::string& url) const
+    {
+        std::vector<int> scriptIds;
+
+        auto range = m_urls.equal_range(url);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            scriptIds.push_back(it->second);
+        }
+
+        return scriptIds;
+    }
+
+    const std::vector<int>& ScriptRegistry::ScriptIds() const
+    {
+        return m_scriptIds;
+    }
+
+    bool ScriptRegistry::ToOriginal(const SourceLocation& generated, SourceLocation* original) const
+    {
+        auto map = m_sourceMaps.find(generated.scriptId);
+        if (map == m_sourceMaps.end() || generated.line < 0 || generated.column < 0)
+        {
+            return false;
+        }
+
+        SourceMap::Mapping mapping;
+        if (!map->second.sourceMap->ToOriginal(generated.line, generated.column, &mapping))
+        {
+            return false;
+        }
+
+        original->scriptId = map->second.firstSourceId + static_cast<int>(mapping.source);
+        original->line = static_cast<int>(mapping.originalLine);
+        original->column = static_cast<int>(mapping.originalColumn);
+        return true;
+    }
+
+    bool ScriptRegistry::ToGenerated(const SourceLocation& original, SourceLocation* generated) const
+    {
+        const ScriptInfo* script = Find(original.scriptId);
+        if (script == nullptr || script->generatedScriptId == -1 || original.line < 0 || original.column < 0)
+        {
+            return false;
+        }
+
+        SourceMap::Mapping mapping;
+        const SourceMap& map = *m_sourceMaps.at(script->generatedScriptId).sourceMap;
+        if (!map.ToGenerated(script->sourceIndex, original.line, original.column, &mapping))
+        {
+            return false;
+        }
+
+        generated->scriptId = script->generatedScriptId;
+        generated->line = static_cast<int>(mapping.generatedLine);
+        generated->column = static_cast<int>(mapping.generatedColumn);
+        return true;
+    }
+
+    bool ScriptRegistry::TryGetSourceContent(int scriptId, const std::string** content) const
+    {
+        const ScriptInfo* script = Find(scriptId);
+        if (script == nullptr || script->generatedScriptId == -1)
+        {
+            return false;
+        }
+
+        const SourceMap& map = *m_sourceMaps.at(script->generatedScriptId).sourceMap;
+        return map.TryGetSourceContent(script->sourceIndex, content);
+    }
+
+    void ScriptRegistry::SetMaxSourceMapFileSize(size_t maxFileSize)
+    {
+        m_maxSourceMapFileSize = maxFileSize;
+    }
+
+    std::shared_ptr<SourceMap> ScriptRegistry::LoadSourceMap(
+        const std::string& sourceMapUrl,
+        const std::string& scriptUrl,
+        std::string* resolvedUrl) const
+    {
+        std::string json;
+
+        if (StartsWith(sourceMapUrl, kDataUrlPrefix))
+        {
+            // Inline maps are almost always base64; sources in them are relative to the script.
+            size_t comma = sourceMapUrl.find(',');
+            if (comma == std::string::npos)
+            {
+                return nullptr;
+            }
+
+            const char* data = sourceMapUrl.c_str() + comma + 1;
+            size_t length = sourceMapUrl.length() - comma - 1;
+
+            if (sourceMapUrl.rfind(";base64", comma) != std::string::npos)
+            {
+                if (!SourceMap::DecodeBase64(data, length, &json))
+                {
+                    return nullptr;
+                }
+            }
+            else
+            {
+                json.assign(data, length);
+            }
+
+            *resolvedUrl = scriptUrl;
+        }
+        else
+        {
+            *resolvedUrl = Resolve(scriptUrl, sourceMapUrl);
+
+            // Anything that isn't inline is left for the frontend to fetch unless the host allows reading files here.
+            if (m_maxSourceMapFileSize == 0)
+            {
+                return nullptr;
+            }
+
+            std::string path = *resolvedUrl;
+            if (StartsWith(path, kFileUrlPrefix))
+            {
+                path.erase(0, std::char_traits<char>::length(kFileUrlPrefix));
+                if (StartsWith(path, kLocalHost))
+                {
+                    path.erase(0, std::char_traits<char>::length(kLocalHost));
+                }
+                else if (!StartsWith(path, "/"))
+                {
+                    // file://host/share/file.js.map
+                    return nullptr;
+                }
+
+                // file:///C:/dir/file.js.map
+                if (path.length() > 3 && path[0] == '/' && path[2] == ':')
+                {
+                    path.erase(0, 1);
+                }
+            }
+            else if (HasScheme(path))
+            {
+                return nullptr;
+            }
+
+            if (!ReadLocalFile(path, m_maxSourceMapFileSize, &json))
+            {
+                return nullptr;
+            }
+        }
+
+        return SourceMap::Parse(json.c_str(), json.length());
+    }
+
+    void ScriptRegistry::Insert(ScriptInfo script)
+    {
+        int scriptId = script.scriptId;
+
+        m_urls.emplace(script.url, scriptId);
+        m_scriptIds.push_back(scriptId);
+        m_scripts.emplace(scriptId, std::move(script));
+    }
+}
@@ -0,0 +1,105 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SourceMap.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace JsDebug
+{
+    struct SourceLocation
+    {
+        int scriptId;
+        int line;
+        int column;
+    };
+
+    struct ScriptInfo
+    {
+        int scriptId;
+        std::string url;
+        int endLine;
+        int endColumn;
+
+        // Only set when the source map couldn't be loaded here, so the frontend can try it instead.
+        std::string sourceMapUrl;
+
+        // Original sources from a source map are exposed as scripts of their own. For those, this is the id of the
+        // generated script and the index of the source in its map; for real scripts it is -1.
+        int generatedScriptId;
+        uint32_t sourceIndex;
+    };
+
+    //
+    // All the scripts known to the debugger, along with the decoded source maps of any that reference one. Every
+    // original source listed in a map gets a script id of its own, so that locations can be reported (and
+    // breakpoints set) in terms of the original files without the frontend having to fetch and decode the map.
+    //
+    class ScriptRegistry
+    {
+    public:
+        ScriptRegistry();
+        ~ScriptRegistry();
+
+        // Ignores scripts that are already registered. The ids of the new entries (the script itself followed by
+        // its original sources) are appended to addedIds.
+        void AddScript(
+            int scriptId,
+            const std::string& url,
+            int lineCount,
+            const std::string& sourceMapUrl,
+            std::vector<int>* addedIds);
+
+        const ScriptInfo* Find(int scriptId) const;
+        std::vector<int> FindByUrl(const std::string& url) const;
+
+        // In registration order.
+        const std::vector<int>& ScriptIds() const;
+
+        // Both return false (and leave the result alone) when there is no mapping for the location.
+        bool ToOriginal(const SourceLocation& generated, SourceLocation* original) const;
+        bool ToGenerated(const SourceLocation& original, SourceLocation* generated) const;
+
+        // Only available for original sources whose map included their content.
+        bool TryGetSourceContent(int scriptId, const std::string** content) const;
+
+        // Maps that aren't inline are only read from disk when this is non-zero, and then only from regular local
+        // files up to this size.
+        void SetMaxSourceMapFileSize(size_t maxFileSize);
+
+    private:
+        std::shared_ptr<SourceMap> LoadSourceMap(
+            const std::string& sourceMapUrl,
+            const std::string& scriptUrl,
+            std::string* resolvedUrl) const;
+
+        void Insert(ScriptInfo script);
+
+        std::unordered_map<int, ScriptInfo> m_scripts;
+        std::vector<int> m_scriptIds;
+        std::unordered_multimap<std::string, int> m_urls;
+
+        struct LoadedSourceMap
+        {
+            std::shared_ptr<SourceMap> sourceMap;
+
+            // The original sources get consecutive ids starting here, in the order the map lists them.
+            int firstSourceId;
+        };
+
+        // Keyed by the id of the generated script.
+        std::unordered_map<int, LoadedSourceMap> m_sourceMaps;
+
+        // Ids handed out to original sources, in a range the engine doesn't use.
+        int m_nextOriginalSourceId;
+
+        size_t m_maxSourceMapFileSize;
+    };
+}
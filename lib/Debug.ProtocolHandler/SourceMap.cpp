@@ -0,0 +1,408 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "SourceMap.h"
+
+#include <protocol\Protocol.h>
+
+#include <algorithm>
+
+namespace JsDebug
+{
+    namespace
+    {
+        // Source maps encode VLQ digits with the standard base64 alphabet; anything else maps to -1.
+        class Base64Table
+        {
+        public:
+            Base64Table()
+            {
+                const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+                std::fill(std::begin(m_values), std::end(m_values), static_cast<int8_t>(-1));
+                for (int i = 0; i < 64; i++)
+                {
+                    m_values[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+                }
+            }
+
+            int8_t operator[](char c) const
+            {
+                return m_values[static_cast<uint8_t>(c)];
+            }
+
+        private:
+            int8_t m_values[256];
+        };
+
+        const Base64Table s_base64;
+
+        const int kVlqContinuationBit = 32;
+        const int kVlqValueMask = 31;
+        const int kVlqShift = 5;
+
+        bool ReadStringArray(
+            protocol::DictionaryValue* map,
+            const char* name,
+            std::vector<std::string>* values,
+            std::vector<bool>* present)
+        {
+            protocol::ListValue* list = map->getArray(name);
+            if (list == nullptr)
+            {
+                return false;
+            }
+
+            values->resize(list->size());
+            present->assign(list->size(), false);
+
+            for (size_t i = 0; i < list->size(); i++)
+            {
+                String16 value;
+                if (list->at(i)->asString(&value))
+                {
+                    (*values)[i] = value.toUTF8();
+                    (*present)[i] = true;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    std::unique_ptr<SourceMap> SourceMap::Parse(const char* json, size_t length)
+    {
+        std::unique_ptr<protocol::Value> value = protocol::parseJSONCharacters(
+            reinterpret_cast<const uint8_t*>(json),
+            static_cast<unsigned int>(length));
+
+        protocol::DictionaryValue* map = protocol::DictionaryValue::cast(value.get());
+        if (map == nullptr)
+        {
+            return nullptr;
+        }
+
+        int version = 0;
+        String16 mappings;
+        if (!map->getInteger("version", &version) || version != 3 || !map->getString("mappings", &mappings))
+        {
+            return nullptr;
+        }
+
+        auto sourceMap = std::make_unique<SourceMap>();
+
+        std::vector<bool> hasSource;
+        if (!ReadStringArray(map, "sources", &sourceMap->m_sources, &hasSource))
+        {
+            return nullptr;
+        }
+
+        String16 sourceRoot;
+        if (map->getString("sourceRoot", &sourceRoot) && !sourceRoot.empty())
+        {
+            std::string root = sourceRoot.toUTF8();
+            if (root.back() != '/')
+            {
+                root.push_back('/');
+            }
+
+            for (auto& source : sourceMap->m_sources)
+            {
+                source.insert(0, root);
+            }
+        }
+
+        if (!ReadStringArray(map, "sourcesContent", &sourceMap->m_sourceContents, &sourceMap->m_hasSourceContent))
+        {
+            sourceMap->m_sourceContents.clear();
+            sourceMap->m_hasSourceContent.clear();
+        }
+
+        std::string encoded = mappings.toUTF8();
+        if (!sourceMap->DecodeMappings(encoded.c_str(), encoded.length(), sourceMap->m_sources.size()))
+        {
+            return nullptr;
+        }
+
+        return sourceMap;
+    }
+
+    bool SourceMap::DecodeBase64(const char* encoded, size_t length, std::string* decoded)
+    {
+        decoded->clear();
+        decoded->reserve(length / 4 * 3);
+
+        uint32_t buffer = 0;
+        int bits = 0;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (encoded[i] == '=')
+            {
+                break;
+            }
+
+            int8_t value = s_base64[encoded[i]];
+            if (value < 0)
+            {
+                return false;
+            }
+
+            buffer = (buffer << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+
+            if (bits >= 8)
+            {
+                bits -= 8;
+                decoded->push_back(static_cast<char>((buffer >> bits) & 0xff));
+            }
+        }
+
+        return true;
+    }
+
+    SourceMap::SourceMap()
+    {
+    }
+
+    SourceMap::~SourceMap()
+    {
+    }
+
+    bool SourceMap::DecodeMappings(const char* mappings, size_t length, size_t sourceCount)
+    {
+        m_mappings.clear();
+        m_originalIndex.clear();
+
+        // Rough guess of the segment count so that large maps don't keep reallocating.
+        m_mappings.reserve(length / 6);
+
+        // Every field except the generated column is relative to its value in the previous segment of the whole
+        // map; the generated column is relative to the previous segment on the same line.
+        int32_t fields[5] = {};
+        int32_t generatedLine = 0;
+
+        const char* current = mappings;
+        const char* end = mappings + length;
+
+        while (current < end)
+        {
+            if (*current == ';')
+            {
+                generatedLine++;
+                fields[0] = 0;
+                current++;
+                continue;
+            }
+
+            if (*current == ',')
+            {
+                current++;
+                continue;
+            }
+
+            int fieldCount = 0;
+
+            while (current < end && *current != ',' && *current != ';')
+            {
+                if (fieldCount == 5)
+                {
+                    return false;
+                }
+
+                uint32_t value = 0;
+                int shift = 0;
+                int digit = 0;
+
+                do
+                {
+                    if (current == end || shift >= 32)
+                    {
+                        return false;
+                    }
+
+                    digit = s_base64[*current++];
+                    if (digit < 0)
+                    {
+                        return false;
+                    }
+
+                    value |= static_cast<uint32_t>(digit & kVlqValueMask) << shift;
+                    shift += kVlqShift;
+                } while (digit & kVlqContinuationBit);
+
+                // The sign is stored in the lowest bit.
+                int32_t magnitude = static_cast<int32_t>(value >> 1);
+                int32_t delta = (value & 1) ? -magnitude : magnitude;
+                fields[fieldCount++] += delta;
+            }
+
+            if (fieldCount != 1 && fieldCount != 4 && fieldCount != 5)
+            {
+                return false;
+            }
+
+            if (fields[0] < 0)
+            {
+                return false;
+            }
+
+            Mapping mapping = {};
+            mapping.generatedLine = static_cast<uint32_t>(generatedLine);
+            mapping.generatedColumn = static_cast<uint32_t>(fields[0]);
+            mapping.source = kNoSource;
+
+            if (fieldCount >= 4)
+            {
+                if (fields[1] < 0 || static_cast<size_t>(fields[1]) >= sourceCount || fields[2] < 0 || fields[3] < 0)
+                {
+                    return false;
+                }
+
+                mapping.source = static_cast<uint32_t>(fields[1]);
+                mapping.originalLine = static_cast<uint32_t>(fields[2]);
+                mapping.originalColumn = static_cast<uint32_t>(fields[3]);
+            }
+
+            m_mappings.push_back(mapping);
+        }
+
+        m_mappings.shrink_to_fit();
+
+        // Generators almost always emit segments in order, so only sort when they didn't.
+        auto generatedLess = [](const Mapping& a, const Mapping& b)
+        {
+            return a.generatedLine < b.generatedLine ||
+                (a.generatedLine == b.generatedLine && a.generatedColumn < b.generatedColumn);
+        };
+
+        if (!std::is_sorted(m_mappings.begin(), m_mappings.end(), generatedLess))
+        {
+            std::stable_sort(m_mappings.begin(), m_mappings.end(), generatedLess);
+        }
+
+        m_originalIndex.reserve(m_mappings.size());
+        for (uint32_t i = 0; i < m_mappings.size(); i++)
+        {
+            if (m_mappings[i].source != kNoSource)
+            {
+                m_originalIndex.push_back(i);
+            }
+        }
+
+        // Ties go to the earliest generated position, which is where a breakpoint on that original position belongs.
+        std::sort(m_originalIndex.begin(), m_originalIndex.end(), [this](uint32_t a, uint32_t b)
+        {
+            const Mapping& left = m_mappings[a];
+            const Mapping& right = m_mappings[b];
+
+            if (left.source != right.source)
+            {
+                return left.source < right.source;
+            }
+
+            if (left.originalLine != right.originalLine)
+            {
+                return left.originalLine < right.originalLine;
+            }
+
+            if (left.originalColumn != right.originalColumn)
+            {
+                return left.originalColumn < right.originalColumn;
+            }
+
+            return a < b;
+        });
+
+        return true;
+    }
+
+    size_t SourceMap::SourceCount() const
+    {
+        return m_sources.size();
+    }
+
+    const std::string& SourceMap::GetSource(size_t index) const
+    {
+        return m_sources[index];
+    }
+
+    bool SourceMap::TryGetSourceContent(size_t index, const std::string** content) const
+    {
+        if (index >= m_hasSourceContent.size() || !m_hasSourceContent[index])
+        {
+            return false;
+        }
+
+        *content = &m_sourceContents[index];
+        return true;
+    }
+
+    bool SourceMap::ToOriginal(uint32_t line, uint32_t column, Mapping* mapping) const
+    {
+        // The covering segment is the last one that starts at or before the position.
+        auto it = std::upper_bound(m_mappings.begin(), m_mappings.end(), std::make_pair(line, column),
+            [](const std::pair<uint32_t, uint32_t>& position, const Mapping& m)
+        {
+            return position.first < m.generatedLine ||
+                (position.first == m.generatedLine && position.second < m.generatedColumn);
+        });
+
+        if (it == m_mappings.begin())
+        {
+            return false;
+        }
+
+        --it;
+        if (it->generatedLine != line || it->source == kNoSource)
+        {
+            return false;
+        }
+
+        *mapping = *it;
+        return true;
+    }
+
+    bool SourceMap::ToGenerated(uint32_t source, uint32_t line, uint32_t column, Mapping* mapping) const
+    {
+        auto it = std::lower_bound(m_originalIndex.begin(), m_originalIndex.end(), 0,
+            [this, source, line, column](uint32_t index, int)
+        {
+            const Mapping& m = m_mappings[index];
+
+            if (m.source != source)
+            {
+                return m.source < source;
+            }
+
+            if (m.originalLine != line)
+            {
+                return m.originalLine < line;
+            }
+
+            return m.originalColumn < column;
+        });
+
+        if (it == m_originalIndex.end())
+        {
+            return false;
+        }
+
+        const Mapping& found = m_mappings[*it];
+        if (found.source != source || found.originalLine != line)
+        {
+            return false;
+        }
+
+        *mapping = found;
+        return true;
+    }
+
+    size_t SourceMap::MappingCount() const
+    {
+        return m_mappings.size();
+    }
+}
@@ -0,0 +1,71 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace JsDebug
+{
+    //
+    // A decoded (version 3) source map. The mappings are decoded once into a flat array sorted by generated position,
+    // plus an index into it sorted by original position, so that mapping in either direction is a binary search.
+    // All positions are 0-based.
+    //
+    class SourceMap
+    {
+    public:
+        static const uint32_t kNoSource = UINT32_MAX;
+
+        struct Mapping
+        {
+            uint32_t generatedLine;
+            uint32_t generatedColumn;
+
+            // kNoSource for segments that only mark the end of a mapped range.
+            uint32_t source;
+            uint32_t originalLine;
+            uint32_t originalColumn;
+        };
+
+        // Returns nullptr if the JSON isn't a source map this can handle (index maps aren't supported).
+        static std::unique_ptr<SourceMap> Parse(const char* json, size_t length);
+
+        // Decodes standard base64, as used by data: URLs.
+        static bool DecodeBase64(const char* encoded, size_t length, std::string* decoded);
+
+        SourceMap();
+        ~SourceMap();
+
+        // Decodes the "mappings" field. Returns false if it is malformed or refers to a source that doesn't exist.
+        bool DecodeMappings(const char* mappings, size_t length, size_t sourceCount);
+
+        size_t SourceCount() const;
+        const std::string& GetSource(size_t index) const;
+
+        // Returns false if the map didn't include the content of the source.
+        bool TryGetSourceContent(size_t index, const std::string** content) const;
+
+        // Finds the mapping covering a generated position, which must be on the same line.
+        bool ToOriginal(uint32_t line, uint32_t column, Mapping* mapping) const;
+
+        // Finds the first generated position for an original position, or the closest one after it on the same line.
+        bool ToGenerated(uint32_t source, uint32_t line, uint32_t column, Mapping* mapping) const;
+
+        size_t MappingCount() const;
+
+    private:
+        std::vector<std::string> m_sources;
+        std::vector<std::string> m_sourceContents;
+        std::vector<bool> m_hasSourceContent;
+
+        std::vector<Mapping> m_mappings;
+        std::vector<uint32_t> m_originalIndex;
+    };
+}
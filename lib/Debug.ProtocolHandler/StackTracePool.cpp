@@ -0,0 +1,136 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "StackTracePool.h"
+
+#include <protocol\Runtime.h>
+
+namespace JsDebug
+{
+    StackTracePool::StackTracePool(size_t maxFrames, size_t maxStacks)
+        : m_maxFrames(maxFrames)
+        , m_maxStacks(maxStacks)
+    {
+        Clear();
+    }
+
+    StackTracePool::~StackTracePool()
+    {
+    }
+
+    void StackTracePool::EnsureCapacity(size_t frameCount)
+    {
+        if (m_frames.size() + frameCount > m_maxFrames || m_stacks.size() + frameCount > m_maxStacks)
+        {
+            Clear();
+        }
+    }
+
+    void StackTracePool::Clear()
+    {
+        m_frames.clear();
+        m_frameIds.clear();
+        m_stacks.clear();
+        m_stackIds.clear();
+
+        // Node 0 is the empty stack that all other stacks grow from.
+        m_stacks.push_back(StackNode{ kEmptyStack, 0, "{\"callFrames\":[]}" });
+    }
+
+    bool StackTracePool::TryGetFrame(int scriptId, int lineNumber, int columnNumber, uint32_t* frameId) const
+    {
+        auto it = m_frameIds.find(FrameKey{ scriptId, lineNumber, columnNumber });
+        if (it == m_frameIds.end())
+        {
+            return false;
+        }
+
+        *frameId = it->second;
+        return true;
+    }
+
+    uint32_t StackTracePool::AddFrame(
+        int scriptId,
+        int lineNumber,
+        int columnNumber,
+        const std::string& url,
+        const std::string& functionName)
+    {
+        FrameKey key{ scriptId, lineNumber, columnNumber };
+
+        auto it = m_frameIds.find(key);
+        if (it != m_frameIds.end())
+        {
+            return it->second;
+        }
+
+        std::unique_ptr<protocol::Runtime::CallFrame> callFrame = protocol::Runtime::CallFrame::create()
+            .setFunctionName(String16::fromUTF8(functionName.c_str(), functionName.length()))
+            .setScriptId(String16(std::to_string(scriptId).c_str()))
+            .setUrl(String16::fromUTF8(url.c_str(), url.length()))
+            .setLineNumber(lineNumber)
+            .setColumnNumber(columnNumber)
+            .build();
+
+        uint32_t frameId = static_cast<uint32_t>(m_frames.size());
+        m_frames.push_back(callFrame->serialize().toUTF8());
+        m_frameIds.emplace(key, frameId);
+
+        return frameId;
+    }
+
+    uint32_t StackTracePool::InternStack(uint32_t parentId, uint32_t frameId)
+    {
+        uint64_t key = (static_cast<uint64_t>(parentId) << 32) | frameId;
+
+        auto it = m_stackIds.find(key);
+        if (it != m_stackIds.end())
+        {
+            return it->second;
+        }
+
+        uint32_t stackId = static_cast<uint32_t>(m_stacks.size());
+        m_stacks.push_back(StackNode{ parentId, frameId, std::string() });
+        m_stackIds.emplace(key, stackId);
+
+        return stackId;
+    }
+
+    const std::string& StackTracePool::GetSerializedStackTrace(uint32_t stackId)
+    {
+        StackNode& stack = m_stacks[stackId];
+        if (!stack.serialized.empty())
+        {
+            return stack.serialized;
+        }
+
+        std::string serialized = "{\"callFrames\":[";
+
+        // Walking towards the root visits the frames innermost first, which is the order the protocol expects.
+        for (uint32_t id = stackId; id != kEmptyStack; id = m_stacks[id].parentId)
+        {
+            if (id != stackId)
+            {
+                serialized.push_back(',');
+            }
+
+            serialized.append(m_frames[m_stacks[id].frameId]);
+        }
+
+        serialized.append("]}");
+
+        stack.serialized = std::move(serialized);
+        return stack.serialized;
+    }
+
+    size_t StackTracePool::FrameKeyHash::operator()(const FrameKey& key) const
+    {
+        size_t hash = std::hash<int>()(key.scriptId);
+        hash = hash * 31 + std::hash<int>()(key.lineNumber);
+        hash = hash * 31 + std::hash<int>()(key.columnNumber);
+        return hash;
+    }
+}
@@ -0,0 +1,90 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace JsDebug
+{
+    //
+    // Hash-consed storage for the stack traces attached to protocol events. Each distinct frame is stored once, and a
+    // stack is a node in a tree of (caller stack, frame) pairs, so stacks that share callers share their prefix and
+    // the same stack always gets the same id. The serialized Runtime.StackTrace is cached per stack id.
+    //
+    // A frame is identified by its script and position alone since a position belongs to exactly one function; this
+    // lets callers skip looking up the function name for frames that are already known.
+    //
+    // Ids are only stable until the pool is cleared, which happens when EnsureCapacity finds it full, so they must
+    // not be held on to between events.
+    //
+    class StackTracePool
+    {
+    public:
+        static const uint32_t kEmptyStack = 0;
+
+        StackTracePool(size_t maxFrames, size_t maxStacks);
+        ~StackTracePool();
+
+        // Makes room for a stack of up to frameCount frames, clearing the pool if it could overflow.
+        void EnsureCapacity(size_t frameCount);
+        void Clear();
+
+        bool TryGetFrame(int scriptId, int lineNumber, int columnNumber, uint32_t* frameId) const;
+        uint32_t AddFrame(
+            int scriptId,
+            int lineNumber,
+            int columnNumber,
+            const std::string& url,
+            const std::string& functionName);
+
+        // Returns the id of the stack made of the given frame called from the parent stack.
+        uint32_t InternStack(uint32_t parentId, uint32_t frameId);
+
+        // Returns the serialized Runtime.StackTrace, innermost frame first.
+        const std::string& GetSerializedStackTrace(uint32_t stackId);
+
+    private:
+        struct FrameKey
+        {
+            int scriptId;
+            int lineNumber;
+            int columnNumber;
+
+            bool operator==(const FrameKey& other) const
+            {
+                return scriptId == other.scriptId &&
+                    lineNumber == other.lineNumber &&
+                    columnNumber == other.columnNumber;
+            }
+        };
+
+        struct FrameKeyHash
+        {
+            size_t operator()(const FrameKey& key) const;
+        };
+
+        struct StackNode
+        {
+            uint32_t parentId;
+            uint32_t frameId;
+            std::string serialized;
+        };
+
+        size_t m_maxFrames;
+        size_t m_maxStacks;
+
+        // Serialized Runtime.CallFrame for each frame id.
+        std::vector<std::string> m_frames;
+        std::unordered_map<FrameKey, uint32_t, FrameKeyHash> m_frameIds;
+
+        std::vector<StackNode> m_stacks;
+        std::unordered_map<uint64_t, uint32_t> m_stackIds;
+    };
+}
@@ -48,10 +48,110 @@ CHAKRA_API JsDebugServiceUnregisterHandler(JsDebugService service, const char* i
     return JsNoError;
 }
 
+CHAKRA_API JsDebugServiceSetIoThreadCount(JsDebugService service, unsigned int threadCount)
+{
+    if (threadCount == 0)
+    {
+        return JsErrorInvalidArgument;
+    }
+
+    auto svc = reinterpret_cast<JsDebug::Service*>(service);
+    svc->SetIoThreadCount(threadCount);
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugServiceSetOutboundQueueLimits(
+    JsDebugService service,
+    size_t maxBytes,
+    size_t maxMessages,
+    JsDebugOverflowPolicy policy)
+{
+    JsDebug::OutboundQueueLimits limits = { maxBytes, maxMessages, JsDebug::OverflowPolicy::DropNotifications };
+
+    switch (policy)
+    {
+    case JsDebugOverflowPolicyDropNotifications:
+        limits.policy = JsDebug::OverflowPolicy::DropNotifications;
+        break;
+    case JsDebugOverflowPolicyCollapseDuplicates:
+        limits.policy = JsDebug::OverflowPolicy::CollapseDuplicates;
+        break;
+    case JsDebugOverflowPolicyDisconnect:
+        limits.policy = JsDebug::OverflowPolicy::Disconnect;
+        break;
+    default:
+        return JsErrorInvalidArgument;
+    }
+
+    auto svc = reinterpret_cast<JsDebug::Service*>(service);
+    svc->SetOutboundQueueLimits(limits);
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugServiceSetCompression(JsDebugService service, int level, size_t minimumSize)
+{
+    if (level < 0 || level > 9)
+    {
+        return JsErrorInvalidArgument;
+    }
+
+    auto svc = reinterpret_cast<JsDebug::Service*>(service);
+    svc->SetCompression(JsDebug::CompressionSettings{ level, minimumSize });
+
+    return JsNoError;
+}
+
 CHAKRA_API JsDebugServiceListen(JsDebugService service, uint16_t port)
 {
     auto svc = reinterpret_cast<JsDebug::Service*>(service);
-    svc->Listen(port);
+    if (!svc->Listen(port))
+    {
+        return JsErrorFatal;
+    }
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugServiceListenTcp(JsDebugService service, const char* address, uint16_t port)
+{
+    if (address == nullptr)
+    {
+        return JsErrorNullArgument;
+    }
+
+    auto svc = reinterpret_cast<JsDebug::Service*>(service);
+    if (!svc->ListenTcp(address, port))
+    {
+        return JsErrorFatal;
+    }
+
+    return JsNoError;
+}
+
+CHAKRA_API JsDebugServiceListenUnix(JsDebugService service, const char* path)
+{
+    if (path == nullptr)
+    {
+        return JsErrorNullArgument;
+    }
+
+    if (path[0] == '\0')
+    {
+        return JsErrorInvalidArgument;
+    }
+
+    if (!JsDebug::Service::SupportsLocalSockets())
+    {
+        return JsErrorNotImplemented;
+    }
+
+    auto svc = reinterpret_cast<JsDebug::Service*>(service);
+    if (!svc->ListenLocal(path))
+    {
+        return JsErrorFatal;
+    }
 
     return JsNoError;
 }
@@ -10,6 +10,15 @@
 
 typedef struct JsDebugService__* JsDebugService;
 
+/// <summary>What to do when messages for a client are produced faster than the client reads them.</summary>
+/// <remarks>Responses and Debugger domain events are never dropped, whatever the policy.</remarks>
+typedef enum _JsDebugOverflowPolicy
+{
+    JsDebugOverflowPolicyDropNotifications = 0,
+    JsDebugOverflowPolicyCollapseDuplicates = 1,
+    JsDebugOverflowPolicyDisconnect = 2,
+} JsDebugOverflowPolicy;
+
 /// <summary>Creates a <seealso cref="JsDebugProtocolHandler" /> instance.</summary>
 /// <param name="service">The newly created instance.</param>
 /// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
@@ -38,12 +47,68 @@ CHAKRA_API JsDebugServiceRegisterHandler(
 /// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
 CHAKRA_API JsDebugServiceUnregisterHandler(JsDebugService service, const char* id);
 
-/// <summary>Start listening on a given port.</summary>
+/// <summary>Set the number of threads that handle network I/O for the service.</summary>
+/// <remarks>Only takes effect if called before <seealso cref="JsDebugServiceListen" />. The default is one.</remarks>
+/// <param name="service">The service instance to configure.</param>
+/// <param name="threadCount">The number of threads to use, which must be at least one.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugServiceSetIoThreadCount(JsDebugService service, unsigned int threadCount);
+
+/// <summary>Limit the messages that can be waiting to be sent to each client.</summary>
+/// <remarks>Applies to connections made after the call.</remarks>
+/// <param name="service">The service instance to configure.</param>
+/// <param name="maxBytes">The maximum size of the queued messages.</param>
+/// <param name="maxMessages">The maximum number of queued messages.</param>
+/// <param name="policy">What to do with a message that doesn't fit.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugServiceSetOutboundQueueLimits(
+    JsDebugService service,
+    size_t maxBytes,
+    size_t maxMessages,
+    JsDebugOverflowPolicy policy);
+
+/// <summary>Configure permessage-deflate compression of the messages sent to clients that support it.</summary>
+/// <remarks>
+///     Applies to handlers registered after the call. By default messages of at least 1 KiB are compressed at level 6.
+/// </remarks>
+/// <param name="service">The service instance to configure.</param>
+/// <param name="level">The compression level, from 1 (fastest) to 9 (smallest), or 0 to turn compression off.</param>
+/// <param name="minimumSize">The size below which messages are sent uncompressed.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugServiceSetCompression(JsDebugService service, int level, size_t minimumSize);
+
+/// <summary>Start listening on a given port on every network interface.</summary>
 /// <param name="service">The service instance to listen with.</param>
 /// <param name="port">The port number to listen on.</param>
 /// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
 CHAKRA_API JsDebugServiceListen(JsDebugService service, uint16_t port);
 
+/// <summary>Start listening on a given TCP endpoint.</summary>
+/// <remarks>
+///     A service listens on at most one TCP endpoint, whether it was given by this or by
+///     <seealso cref="JsDebugServiceListen" />.
+/// </remarks>
+/// <param name="service">The service instance to listen with.</param>
+/// <param name="address">The IPv4 or IPv6 address to listen on, such as "127.0.0.1" or "::1".</param>
+/// <param name="port">The port number to listen on.</param>
+/// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
+CHAKRA_API JsDebugServiceListenTcp(JsDebugService service, const char* address, uint16_t port);
+
+/// <summary>Start listening on a Unix domain socket.</summary>
+/// <remarks>
+///     Clients connect with the same WebSocket protocol as over TCP. This can be called any number of times, with or
+///     without a TCP endpoint as well. A socket file created by the service is removed when the service is closed.
+/// </remarks>
+/// <param name="service">The service instance to listen with.</param>
+/// <param name="path">
+///     The path of the socket, or a name starting with '@' for a socket in the abstract namespace (Linux only).
+/// </param>
+/// <returns>
+///     The code <c>JsNoError</c> if the operation succeeded, <c>JsErrorNotImplemented</c> if the platform has no Unix
+///     domain sockets, a failure code otherwise.
+/// </returns>
+CHAKRA_API JsDebugServiceListenUnix(JsDebugService service, const char* path);
+
 /// <summary>Stop listening and close any connections.</summary>
 /// <param name="service">The service instance to close.</param>
 /// <returns>The code <c>JsNoError</c> if the operation succeeded, a failure code otherwise.</returns>
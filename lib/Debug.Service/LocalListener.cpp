@@ -0,0 +1,168 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "LocalListener.h"
+
+#ifdef JSDEBUG_HAS_LOCAL_SOCKETS
+
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace JsDebug
+{
+    namespace asio = websocketpp::lib::asio;
+
+    using websocketpp::lib::bind;
+    using websocketpp::lib::placeholders::_1;
+
+    using websocketpp::log::elevel;
+
+    LocalListener::LocalListener(websocketpp::server<ServiceConfig>* server)
+        : m_server(server)
+        , m_acceptor(server->get_io_service())
+        , m_socket(server->get_io_service())
+    {
+    }
+
+    LocalListener::~LocalListener()
+    {
+        if (!m_path.empty())
+        {
+            ::unlink(m_path.c_str());
+        }
+    }
+
+    bool LocalListener::Listen(const std::string& path, std::string* error)
+    {
+        std::string name = path;
+        bool abstract = !name.empty() && name[0] == '@';
+
+        if (abstract)
+        {
+#ifdef __linux__
+            name[0] = '\0';
+#else
+            *error = "Abstract socket names aren't supported on this platform";
+            return false;
+#endif
+        }
+
+        // The endpoint throws rather than truncating a name that doesn't fit.
+        if (name.length() >= sizeof(sockaddr_un::sun_path))
+        {
+            *error = "The socket path is too long";
+            return false;
+        }
+
+        asio::error_code ec;
+        asio::local::stream_protocol::endpoint endpoint(name);
+
+        if (!abstract)
+        {
+            RemoveStaleSocket(endpoint);
+        }
+
+        m_acceptor.open(endpoint.protocol(), ec);
+        if (!ec)
+        {
+            m_acceptor.bind(endpoint, ec);
+        }
+
+        if (!ec)
+        {
+            m_acceptor.listen(asio::socket_base::max_connections, ec);
+        }
+
+        if (ec)
+        {
+            *error = ec.message();
+            m_acceptor.close(ec);
+            return false;
+        }
+
+        if (!abstract)
+        {
+            m_path = path;
+        }
+
+        StartAccept();
+        return true;
+    }
+
+    void LocalListener::Close()
+    {
+        // The acceptor is only touched from the I/O threads once it's accepting.
+        m_server->get_io_service().post([this]()
+        {
+            asio::error_code ec;
+            m_acceptor.close(ec);
+        });
+    }
+
+    void LocalListener::RemoveStaleSocket(const asio::local::stream_protocol::endpoint& endpoint)
+    {
+        // A socket file left behind by a process that didn't shut down cleanly would make bind fail. Only sockets that
+        // nothing is listening on are removed, so a running instance keeps its name.
+        struct stat status;
+        if (::lstat(endpoint.path().c_str(), &status) != 0 || !S_ISSOCK(status.st_mode))
+        {
+            return;
+        }
+
+        asio::error_code ec;
+        asio::local::stream_protocol::socket probe(m_server->get_io_service());
+        probe.connect(endpoint, ec);
+
+        if (ec == asio::error::connection_refused)
+        {
+            ::unlink(endpoint.path().c_str());
+        }
+
+        probe.close(ec);
+    }
+
+    void LocalListener::StartAccept()
+    {
+        m_acceptor.async_accept(m_socket, bind(&LocalListener::OnAccept, this, _1));
+    }
+
+    void LocalListener::OnAccept(const asio::error_code& ec)
+    {
+        if (ec == asio::error::operation_aborted || !m_acceptor.is_open())
+        {
+            return;
+        }
+
+        if (ec)
+        {
+            m_server->get_elog().write(elevel::rerror, "Failed to accept local connection: " + ec.message());
+            StartAccept();
+            return;
+        }
+
+        auto connection = m_server->get_connection();
+
+        // The protocol given here is never used: the transport only reads and writes.
+        auto handle = m_socket.release();
+        asio::error_code assignError;
+        connection->get_raw_socket().assign(asio::ip::tcp::v6(), handle, assignError);
+
+        if (assignError)
+        {
+            m_server->get_elog().write(elevel::rerror, "Failed to accept local connection: " + assignError.message());
+            ::close(handle);
+        }
+        else
+        {
+            connection->start();
+        }
+
+        StartAccept();
+    }
+}
+
+#endif
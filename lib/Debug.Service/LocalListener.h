@@ -0,0 +1,49 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ServiceConfig.h"
+
+#include <string>
+
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+#define JSDEBUG_HAS_LOCAL_SOCKETS
+#endif
+
+namespace JsDebug
+{
+#ifdef JSDEBUG_HAS_LOCAL_SOCKETS
+    //
+    // Accepts connections on a Unix domain socket and hands them to the server, which then treats them like any TCP
+    // connection. The server's transport only knows about TCP sockets, but it never needs more from its sockets than
+    // reading and writing, so the accepted descriptor is simply given to the TCP socket of a new connection.
+    //
+    class LocalListener
+    {
+    public:
+        explicit LocalListener(websocketpp::server<ServiceConfig>* server);
+        ~LocalListener();
+
+        // A path starting with '@' names a socket in the abstract namespace, where that is supported.
+        bool Listen(const std::string& path, std::string* error);
+
+        // May be called from any thread.
+        void Close();
+
+    private:
+        void RemoveStaleSocket(const websocketpp::lib::asio::local::stream_protocol::endpoint& endpoint);
+        void StartAccept();
+        void OnAccept(const websocketpp::lib::asio::error_code& ec);
+
+        websocketpp::server<ServiceConfig>* m_server;
+        websocketpp::lib::asio::local::stream_protocol::acceptor m_acceptor;
+        websocketpp::lib::asio::local::stream_protocol::socket m_socket;
+
+        // The file to remove when closing, which is empty for abstract sockets.
+        std::string m_path;
+    };
+#endif
+}
@@ -0,0 +1,133 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "MessageDeflater.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace JsDebug
+{
+    namespace
+    {
+        // Raw deflate with the largest window, which is what the client gets unless it asked for a smaller one.
+        const int kWindowBits = -15;
+        const int kMemoryLevel = 8;
+
+        // A sync flush ends with an empty stored block, which permessage-deflate leaves off the end of every message.
+        const char kFlushTrailer[] = { '\x00', '\x00', '\xff', '\xff' };
+
+        // deflateBound assumes the stream gets finished, so leave room for a flush as well.
+        const size_t kFlushMargin = 16;
+    }
+
+    MessageDeflater::MessageDeflater(const CompressionSettings& settings)
+        : m_settings(settings)
+        , m_stream()
+        , m_initialized(false)
+    {
+        if (m_settings.level > 0)
+        {
+            m_initialized = deflateInit2(
+                &m_stream,
+                m_settings.level,
+                Z_DEFLATED,
+                kWindowBits,
+                kMemoryLevel,
+                Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+    }
+
+    MessageDeflater::~MessageDeflater()
+    {
+        if (m_initialized)
+        {
+            deflateEnd(&m_stream);
+        }
+    }
+
+    bool MessageDeflater::IsEnabled() const
+    {
+        return m_initialized;
+    }
+
+    bool MessageDeflater::Compress(const char* payload, size_t length, std::string* compressed)
+    {
+        if (!m_initialized || length < m_settings.minimumSize)
+        {
+            return false;
+        }
+
+        compressed->clear();
+        bool complete = Deflate(payload, length, Z_SYNC_FLUSH, compressed);
+        deflateReset(&m_stream);
+
+        if (!complete || compressed->length() < sizeof(kFlushTrailer))
+        {
+            return false;
+        }
+
+        size_t written = compressed->length() - sizeof(kFlushTrailer);
+        if (std::memcmp(compressed->data() + written, kFlushTrailer, sizeof(kFlushTrailer)) != 0 || written >= length)
+        {
+            return false;
+        }
+
+        compressed->resize(written);
+        return true;
+    }
+
+    void MessageDeflater::CompressFragment(const char* payload, size_t length, bool final, std::string* compressed)
+    {
+        compressed->swap(m_heldBack);
+        m_heldBack.clear();
+
+        Deflate(payload, length, final ? Z_SYNC_FLUSH : Z_NO_FLUSH, compressed);
+
+        size_t heldBack = (std::min)(compressed->length(), sizeof(kFlushTrailer));
+        if (final)
+        {
+            deflateReset(&m_stream);
+        }
+        else
+        {
+            m_heldBack.assign(*compressed, compressed->length() - heldBack, heldBack);
+        }
+
+        compressed->resize(compressed->length() - heldBack);
+    }
+
+    bool MessageDeflater::Deflate(const char* payload, size_t length, int flush, std::string* compressed)
+    {
+        size_t written = compressed->length();
+
+        m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload));
+        m_stream.avail_in = static_cast<uInt>(length);
+
+        // Input held over from earlier fragments can make the output larger than the bound for this one, so keep
+        // going until deflate stops filling the buffer.
+        do
+        {
+            size_t capacity = written + deflateBound(&m_stream, m_stream.avail_in) + kFlushMargin;
+            compressed->resize(capacity);
+
+            m_stream.next_out = reinterpret_cast<Bytef*>(&(*compressed)[written]);
+            m_stream.avail_out = static_cast<uInt>(capacity - written);
+
+            int result = deflate(&m_stream, flush);
+            written = capacity - m_stream.avail_out;
+
+            if (result != Z_OK && result != Z_BUF_ERROR)
+            {
+                compressed->resize(written);
+                return false;
+            }
+        } while (m_stream.avail_out == 0);
+
+        compressed->resize(written);
+        return true;
+    }
+}
@@ -0,0 +1,53 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+
+#include <zlib.h>
+
+namespace JsDebug
+{
+    struct CompressionSettings
+    {
+        // The zlib compression level, from 1 (fastest) to 9 (smallest). Zero turns compression off.
+        int level;
+
+        // Messages smaller than this are always sent as they are.
+        size_t minimumSize;
+    };
+
+    //
+    // Compresses message payloads for permessage-deflate. Every message is compressed on its own, as negotiated by
+    // ServerDeflateExtension, so the result can be sent on any connection that accepts compression.
+    //
+    class MessageDeflater
+    {
+    public:
+        explicit MessageDeflater(const CompressionSettings& settings);
+        ~MessageDeflater();
+
+        bool IsEnabled() const;
+
+        // Returns false if the message should be sent uncompressed, because it's too small or doesn't get any smaller.
+        bool Compress(const char* payload, size_t length, std::string* compressed);
+
+        // Compresses a message that is sent in fragments, one fragment at a time. The output for each fragment is the
+        // payload of the next frame, and can be empty for all but the last one. Only one message can be compressed
+        // this way at a time, and no other in between.
+        void CompressFragment(const char* payload, size_t length, bool final, std::string* compressed);
+
+    private:
+        bool Deflate(const char* payload, size_t length, int flush, std::string* compressed);
+
+        const CompressionSettings m_settings;
+        z_stream m_stream;
+        bool m_initialized;
+
+        // The end of the output for the last fragment, which could be part of the flush trailer.
+        std::string m_heldBack;
+    };
+}
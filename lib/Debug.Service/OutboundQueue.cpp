@@ -0,0 +1,246 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "OutboundQueue.h"
+
+#include <algorithm>
+
+namespace JsDebug
+{
+    namespace
+    {
+        // Messages are only handed to the connection while it has less than this much waiting to be written.
+        const size_t kConnectionWatermark = 256 * 1024;
+
+        size_t MessageSize(const OutboundQueue::message_ptr& message)
+        {
+            return message->get_header().length() + message->get_payload().length();
+        }
+    }
+
+    OutboundQueue::OutboundQueue(const OutboundQueueLimits& limits)
+        : m_limits(limits)
+        , m_bytes(0)
+        , m_flushPending(false)
+        , m_inFragmentedMessage(false)
+        , m_droppedCount(0)
+    {
+    }
+
+    OutboundQueue::~OutboundQueue()
+    {
+    }
+
+    OutboundQueue::PushResult OutboundQueue::Push(message_ptr message, bool essential, bool* needsFlush)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        size_t size = MessageSize(message);
+        *needsFlush = false;
+
+        if (!essential && !HasRoomFor(size))
+        {
+            if (m_limits.policy == OverflowPolicy::Disconnect)
+            {
+                return PushResult::Overflow;
+            }
+
+            if (m_limits.policy == OverflowPolicy::CollapseDuplicates && HasQueuedDuplicate(message))
+            {
+                m_droppedCount++;
+                return PushResult::Dropped;
+            }
+
+            while (!HasRoomFor(size) && DropOldestNotification())
+            {
+            }
+
+            // Everything left is essential.
+            if (!HasRoomFor(size))
+            {
+                m_droppedCount++;
+                return PushResult::Dropped;
+            }
+        }
+
+        m_bytes += size;
+
+        if (essential)
+        {
+            m_control.push_back(Entry{ std::move(message), false, true });
+        }
+        else
+        {
+            m_bulk.push_back(std::move(message));
+        }
+
+        SetFlushPending(needsFlush);
+        return PushResult::Queued;
+    }
+
+    void OutboundQueue::PushFragment(message_ptr frame, bool final, bool* needsFlush)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        *needsFlush = false;
+        m_bytes += MessageSize(frame);
+        m_control.push_back(Entry{ std::move(frame), true, final });
+
+        SetFlushPending(needsFlush);
+    }
+
+    bool OutboundQueue::Flush(connection_ptr connection)
+    {
+        std::deque<message_ptr> ready;
+
+        // Messages pushed while a batch is being handed over don't ask for a flush of their own since this one is
+        // still pending, so it keeps going until nothing is ready or the connection is full.
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+
+                size_t buffered = connection->get_buffered_amount();
+                while (buffered < kConnectionWatermark && TakeNext(&ready, &buffered))
+                {
+                }
+
+                // If the rest has to wait for the next frame of a fragmented message, pushing that frame asks for a
+                // flush. Otherwise anything left is waiting for the connection to drain.
+                if (ready.empty())
+                {
+                    m_flushPending = HasReadyMessage();
+                    return m_flushPending;
+                }
+            }
+
+            // The flush stays pending until the messages have been handed over, so messages still go out in the order
+            // they were pushed. The shared frames are handed over as they are. This runs on the connection's strand,
+            // so the connection can't start writing until it's done, and then writes everything it was handed in one
+            // go.
+            for (const auto& message : ready)
+            {
+                connection->send(message);
+            }
+
+            ready.clear();
+        }
+    }
+
+    void OutboundQueue::Clear()
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_control.clear();
+        m_bulk.clear();
+        m_bytes = 0;
+        m_flushPending = false;
+        m_inFragmentedMessage = false;
+    }
+
+    size_t OutboundQueue::DroppedCount() const
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        return m_droppedCount;
+    }
+
+    bool OutboundQueue::HasRoomFor(size_t size) const
+    {
+        return m_control.size() + m_bulk.size() < m_limits.maxMessages && m_bytes + size <= m_limits.maxBytes;
+    }
+
+    bool OutboundQueue::HasQueuedDuplicate(const message_ptr& message) const
+    {
+        const std::string& payload = message->get_payload();
+
+        auto it = std::find_if(m_bulk.begin(), m_bulk.end(), [&payload](const message_ptr& queued)
+        {
+            return queued->get_payload() == payload;
+        });
+
+        return it != m_bulk.end();
+    }
+
+    bool OutboundQueue::DropOldestNotification()
+    {
+        if (m_bulk.empty())
+        {
+            return false;
+        }
+
+        m_bytes -= MessageSize(m_bulk.front());
+        m_bulk.pop_front();
+        m_droppedCount++;
+        return true;
+    }
+
+    bool OutboundQueue::HasReadyMessage() const
+    {
+        if (m_inFragmentedMessage)
+        {
+            return std::any_of(m_control.begin(), m_control.end(), [](const Entry& entry)
+            {
+                return entry.fragment;
+            });
+        }
+
+        return !m_control.empty() || !m_bulk.empty();
+    }
+
+    bool OutboundQueue::TakeNext(std::deque<message_ptr>* ready, size_t* buffered)
+    {
+        message_ptr message;
+
+        if (m_inFragmentedMessage)
+        {
+            // Messages pushed since the fragmented message started wait until it's done.
+            auto it = std::find_if(m_control.begin(), m_control.end(), [](const Entry& entry)
+            {
+                return entry.fragment;
+            });
+
+            if (it == m_control.end())
+            {
+                return false;
+            }
+
+            m_inFragmentedMessage = !it->final;
+            message = std::move(it->message);
+            m_control.erase(it);
+        }
+        else if (!m_control.empty())
+        {
+            // Essential messages preempt the bulk lane at every message boundary.
+            m_inFragmentedMessage = !m_control.front().final;
+            message = std::move(m_control.front().message);
+            m_control.pop_front();
+        }
+        else if (!m_bulk.empty())
+        {
+            message = std::move(m_bulk.front());
+            m_bulk.pop_front();
+        }
+        else
+        {
+            return false;
+        }
+
+        size_t size = MessageSize(message);
+        *buffered += size;
+        m_bytes -= size;
+
+        ready->push_back(std::move(message));
+        return true;
+    }
+
+    void OutboundQueue::SetFlushPending(bool* needsFlush)
+    {
+        if (!m_flushPending)
+        {
+            m_flushPending = true;
+            *needsFlush = true;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "ServiceConfig.h"
+
+#include <deque>
+#include <mutex>
+
+namespace JsDebug
+{
+    enum class OverflowPolicy
+    {
+        // Make room by discarding the oldest queued notifications.
+        DropNotifications,
+
+        // Like DropNotifications, but a notification identical to one that is still queued is discarded first.
+        CollapseDuplicates,
+
+        // Close the connection.
+        Disconnect,
+    };
+
+    struct OutboundQueueLimits
+    {
+        size_t maxBytes;
+        size_t maxMessages;
+        OverflowPolicy policy;
+    };
+
+    //
+    // Messages waiting to be handed to a connection. Messages are pushed from the engine thread and only moved to the
+    // connection on an I/O thread, and only as fast as the connection drains, so a slow client can't grow the
+    // transport's buffers without bound or hold up the engine. Essential messages (responses and the events the
+    // frontend can't do without) are always accepted; the limits are enforced by discarding the rest.
+    //
+    // Essential messages also travel in a lane of their own that is always drained first, so a pause or a response
+    // doesn't wait behind a flood of console output. Order is only kept within each lane.
+    //
+    // The frames of a fragmented message travel in the essential lane as well. Once its first frame has been handed to
+    // the connection nothing else is until its last frame has been, even if that means waiting for it to be pushed.
+    //
+    class OutboundQueue
+    {
+    public:
+        typedef ServiceConfig::message_type::ptr message_ptr;
+        typedef websocketpp::server<ServiceConfig>::connection_ptr connection_ptr;
+
+        enum class PushResult
+        {
+            Queued,
+            Dropped,
+            Overflow,
+        };
+
+        explicit OutboundQueue(const OutboundQueueLimits& limits);
+        ~OutboundQueue();
+
+        // May be called from any thread. Sets needsFlush when no flush is pending, in which case the caller has to
+        // schedule one on an I/O thread.
+        PushResult Push(message_ptr message, bool essential, bool* needsFlush);
+
+        // Queues the next frame of a fragmented message, which is never dropped. Only one fragmented message can be
+        // pushed at a time.
+        void PushFragment(message_ptr frame, bool final, bool* needsFlush);
+
+        // Must be called on the connection's strand. Hands messages to the connection, including any pushed in the
+        // meantime, while its own buffer is below the watermark. Returns true if messages remain for when it drains,
+        // in which case the flush is still pending and has to be retried.
+        bool Flush(connection_ptr connection);
+
+        void Clear();
+        size_t DroppedCount() const;
+
+    private:
+        struct Entry
+        {
+            message_ptr message;
+            bool fragment;
+            bool final;
+        };
+
+        bool HasRoomFor(size_t size) const;
+        bool HasQueuedDuplicate(const message_ptr& message) const;
+        bool DropOldestNotification();
+        bool HasReadyMessage() const;
+        bool TakeNext(std::deque<message_ptr>* ready, size_t* buffered);
+        void SetFlushPending(bool* needsFlush);
+
+        const OutboundQueueLimits m_limits;
+
+        mutable std::mutex m_lock;
+        std::deque<Entry> m_control;
+        std::deque<message_ptr> m_bulk;
+        size_t m_bytes;
+        bool m_flushPending;
+        bool m_inFragmentedMessage;
+        size_t m_droppedCount;
+    };
+}
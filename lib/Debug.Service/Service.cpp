@@ -6,11 +6,21 @@
 #include "stdafx.h"
 
 #include "Service.h"
+
+#include <JsonReader.h>
+#include <protocol\Protocol.h>
+#include <protocol\ProtocolJson.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 #include <iostream>
 
 namespace JsDebug
 {
-    typedef websocketpp::server<websocketpp::config::asio> server;
+    typedef websocketpp::server<ServiceConfig> server;
 
     using websocketpp::connection_hdl;
 
@@ -18,13 +28,353 @@ namespace JsDebug
     using websocketpp::lib::mutex;
     using websocketpp::lib::placeholders::_1;
     using websocketpp::lib::placeholders::_2;
-    using websocketpp::lib::thread;
     using websocketpp::lib::unique_lock;
 
     using websocketpp::log::alevel;
     using websocketpp::log::elevel;
 
+    namespace
+    {
+        const size_t kDefaultQueueMaxBytes = 16 * 1024 * 1024;
+        const size_t kDefaultQueueMaxMessages = 16 * 1024;
+        const int kDefaultCompressionLevel = 6;
+        const size_t kDefaultCompressionMinimumSize = 1024;
+
+        void AppendJsonEscaped(std::string* json, const std::string& value)
+        {
+            for (char c : value)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    json->push_back('\\');
+                    json->push_back(c);
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    json->append(escaped);
+                }
+                else
+                {
+                    json->push_back(c);
+                }
+            }
+        }
+
+        void AppendJsonString(std::string* json, const std::string& value)
+        {
+            json->push_back('"');
+            AppendJsonEscaped(json, value);
+            json->push_back('"');
+        }
+
+        // Handler ids are chosen by the host, so they're encoded wherever they're used as a URL path segment.
+        std::string PercentEncode(const std::string& value)
+        {
+            static const char kHexDigits[] = "0123456789ABCDEF";
+
+            std::string encoded;
+            for (char c : value)
+            {
+                unsigned char byte = static_cast<unsigned char>(c);
+                if (std::isalnum(byte) || c == '-' || c == '.' || c == '_' || c == '~')
+                {
+                    encoded.push_back(c);
+                }
+                else
+                {
+                    encoded.push_back('%');
+                    encoded.push_back(kHexDigits[byte >> 4]);
+                    encoded.push_back(kHexDigits[byte & 0xf]);
+                }
+            }
+
+            return encoded;
+        }
+
+        int HexValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                return c - '0';
+            }
+
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        }
+
+        // Returns false for a malformed escape.
+        bool PercentDecode(const std::string& value, std::string* decoded)
+        {
+            decoded->clear();
+
+            for (size_t i = 0; i < value.length(); i++)
+            {
+                if (value[i] != '%')
+                {
+                    decoded->push_back(value[i]);
+                    continue;
+                }
+
+                int high = i + 2 < value.length() ? HexValue(value[i + 1]) : -1;
+                int low = high != -1 ? HexValue(value[i + 2]) : -1;
+                if (low == -1)
+                {
+                    return false;
+                }
+
+                decoded->push_back(static_cast<char>((high << 4) | low));
+                i += 2;
+            }
+
+            return true;
+        }
+
+        const char kJsonContentType[] = "application/json; charset=UTF-8";
+        const char kDefaultHost[] = "localhost";
+        const size_t kMaxPortDigits = 5;
+
+        bool IsHostNameCharacter(char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                c == '-' || c == '.' || c == '_';
+        }
+
+        bool IsAddressCharacter(char c)
+        {
+            return (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || (c >= '0' && c <= '9') || c == ':' || c == '.';
+        }
+
+        // Checks a Host header against host[:port], where the host is a name, an IPv4 address or a bracketed IPv6
+        // address. It's echoed into the target list, so nothing that needs escaping gets through.
+        bool IsValidHost(const std::string& host)
+        {
+            size_t pos = 0;
+
+            if (!host.empty() && host[0] == '[')
+            {
+                size_t close = host.find(']');
+                if (close == std::string::npos || close == 1 ||
+                    !std::all_of(host.begin() + 1, host.begin() + close, IsAddressCharacter))
+                {
+                    return false;
+                }
+
+                pos = close + 1;
+            }
+            else
+            {
+                while (pos < host.length() && IsHostNameCharacter(host[pos]))
+                {
+                    pos++;
+                }
+
+                if (pos == 0)
+                {
+                    return false;
+                }
+            }
+
+            if (pos == host.length())
+            {
+                return true;
+            }
+
+            size_t digits = host.length() - pos - 1;
+            return host[pos] == ':' && digits > 0 && digits <= kMaxPortDigits &&
+                std::all_of(host.begin() + pos + 1, host.end(), [](char c) { return c >= '0' && c <= '9'; });
+        }
+
+        bool HeaderContains(const std::string& header, const char* token)
+        {
+            return header.find(token) != std::string::npos;
+        }
+
+        const std::string& GetProtocolJson()
+        {
+            // Only clients that can't take the compressed form need this, so it's only inflated if one asks.
+            static const std::string json = []
+            {
+                std::string result(protocol::kProtocolJsonLength, '\0');
+
+                z_stream stream = {};
+                if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+                {
+                    return std::string();
+                }
+
+                stream.next_in = const_cast<Bytef*>(protocol::kProtocolJsonGzip);
+                stream.avail_in = static_cast<uInt>(sizeof(protocol::kProtocolJsonGzip));
+                stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+                stream.avail_out = static_cast<uInt>(result.size());
+
+                int status = inflate(&stream, Z_FINISH);
+                inflateEnd(&stream);
+
+                if (status != Z_STREAM_END || stream.total_out != result.size())
+                {
+                    return std::string();
+                }
+
+                return result;
+            }();
+
+            return json;
+        }
+
+        std::string MakeResult(int id, const std::string& result)
+        {
+            return "{\"id\":" + std::to_string(id) + ",\"result\":" + result + "}";
+        }
+
+        std::string MakeError(const std::string& id, int code, const std::string& message)
+        {
+            std::string error = "{\"id\":" + id + ",\"error\":{\"code\":" + std::to_string(code) + ",\"message\":";
+            AppendJsonString(&error, message);
+            error.append("}}");
+            return error;
+        }
+
+        std::string MakeError(int id, int code, const std::string& message)
+        {
+            return MakeError(std::to_string(id), code, message);
+        }
+
+        // The top-level fields a session connection routes commands by.
+        struct SessionCommand
+        {
+            bool hasId;
+            int id;
+            bool hasSessionId;
+            std::string sessionId;
+            std::string method;
+        };
+
+        //
+        // Picks out a SessionCommand in one pass over the message. Nothing is built for the params.
+        //
+        class SessionCommandReader : public JsonReader::Handler
+        {
+        public:
+            explicit SessionCommandReader(SessionCommand* command)
+                : m_command(command)
+                , m_depth(0)
+                , m_field(Field::None)
+            {
+            }
+
+            bool OnObjectStart() override
+            {
+                return Enter();
+            }
+
+            bool OnObjectEnd() override
+            {
+                m_depth--;
+                return true;
+            }
+
+            bool OnArrayStart() override
+            {
+                return Enter();
+            }
+
+            bool OnArrayEnd() override
+            {
+                m_depth--;
+                return true;
+            }
+
+            bool OnKey(const char* key, size_t length) override
+            {
+                m_field = Field::None;
+
+                if (m_depth == 1)
+                {
+                    std::string name(key, length);
+                    m_field = name == "id" ? Field::Id
+                        : name == "sessionId" ? Field::SessionId
+                        : name == "method" ? Field::Method
+                        : Field::None;
+                }
+
+                return true;
+            }
+
+            bool OnString(const char* str, size_t length) override
+            {
+                if (m_field == Field::SessionId)
+                {
+                    m_command->hasSessionId = true;
+                    m_command->sessionId.assign(str, length);
+                }
+                else if (m_field == Field::Method)
+                {
+                    m_command->method.assign(str, length);
+                }
+
+                m_field = Field::None;
+                return true;
+            }
+
+            bool OnInteger(int32_t value) override
+            {
+                if (m_field == Field::Id)
+                {
+                    m_command->hasId = true;
+                    m_command->id = value;
+                }
+
+                m_field = Field::None;
+                return true;
+            }
+
+            bool OnDouble(double value) override
+            {
+                m_field = Field::None;
+                return true;
+            }
+
+            bool OnBool(bool value) override
+            {
+                m_field = Field::None;
+                return true;
+            }
+
+            bool OnNull() override
+            {
+                m_field = Field::None;
+                return true;
+            }
+
+        private:
+            enum class Field
+            {
+                None,
+                Id,
+                SessionId,
+                Method,
+            };
+
+            bool Enter()
+            {
+                m_depth++;
+                m_field = Field::None;
+                return true;
+            }
+
+            SessionCommand* m_command;
+            int m_depth;
+            Field m_field;
+        };
+    }
+
     Service::Service()
+        : m_ioThreadCount(1)
+        , m_queueLimits{ kDefaultQueueMaxBytes, kDefaultQueueMaxMessages, OverflowPolicy::DropNotifications }
+        , m_compression{ kDefaultCompressionLevel, kDefaultCompressionMinimumSize }
+        , m_nextSessionId(0)
     {
         m_server.set_error_channels(elevel::all);
         m_server.set_access_channels(alevel::all ^ alevel::frame_payload);
@@ -32,6 +382,9 @@ namespace JsDebug
         m_server.init_asio();
         m_server.set_validate_handler(bind(&Service::OnValidate, this, _1));
         m_server.set_close_handler(bind(&Service::OnClose, this, _1));
+        m_server.set_http_handler(bind(&Service::OnHttp, this, _1));
+
+        PublishRegistry(handler_map());
     }
 
     Service::~Service()
@@ -45,41 +398,197 @@ namespace JsDebug
             // Catch any exceptions thrown during destruction
             std::cerr << "Failed to stop server: " << e.what() << std::endl;
         }
+
+        for (auto& thread : m_threads)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
     }
 
     void Service::RegisterHandler(const char* id, JsDebugProtocolHandler protocolHandler, bool breakOnNextLine)
     {
-        unique_lock<mutex> lock(m_lock);
-        m_handlers.emplace(id, std::make_unique<ServiceHandler>(&m_server, id, protocolHandler, breakOnNextLine));
+        unique_lock<mutex> registryLock(m_registryLock);
+
+        OutboundQueueLimits queueLimits;
+        CompressionSettings compression;
+
+        {
+            unique_lock<mutex> lock(m_lock);
+            queueLimits = m_queueLimits;
+            compression = m_compression;
+        }
+
+        handler_map handlers = GetRegistry()->handlers;
+        handlers.emplace(
+            id,
+            std::make_shared<ServiceHandler>(
+                &m_server,
+                id,
+                protocolHandler,
+                breakOnNextLine,
+                queueLimits,
+                compression));
+
+        PublishRegistry(std::move(handlers));
     }
 
     void Service::UnregisterHandler(const char* id)
+    {
+        std::shared_ptr<ServiceHandler> handler;
+
+        {
+            unique_lock<mutex> registryLock(m_registryLock);
+
+            handler_map handlers = GetRegistry()->handlers;
+            auto it = handlers.find(id);
+            if (it == handlers.end())
+            {
+                return;
+            }
+
+            handler = it->second;
+            handlers.erase(it);
+            PublishRegistry(std::move(handlers));
+        }
+
+        // A connection that looked the handler up just before it was removed can still be holding on to it, but the
+        // host is free to destroy the protocol handler as soon as this returns, so it's closed here and now.
+        handler->Close();
+    }
+
+    void Service::SetIoThreadCount(size_t count)
+    {
+        m_ioThreadCount = (std::max)(count, static_cast<size_t>(1));
+    }
+
+    void Service::SetOutboundQueueLimits(const OutboundQueueLimits& limits)
+    {
+        // Holding the registry lock keeps a handler from being registered with the old limits in the meantime.
+        unique_lock<mutex> registryLock(m_registryLock);
+
+        {
+            unique_lock<mutex> lock(m_lock);
+            m_queueLimits = limits;
+        }
+
+        auto registry = GetRegistry();
+        for (const auto& handler : registry->handlers)
+        {
+            handler.second->SetOutboundQueueLimits(limits);
+        }
+    }
+
+    void Service::SetCompression(const CompressionSettings& compression)
     {
         unique_lock<mutex> lock(m_lock);
-        m_handlers.erase(id);
+        m_compression = compression;
+    }
+
+    bool Service::Listen(uint16_t port)
+    {
+        try
+        {
+            m_server.listen(port);
+            m_server.start_accept();
+        }
+        catch (const websocketpp::exception& e)
+        {
+            std::cerr << "Failed to start server: " << e.what() << std::endl;
+            return false;
+        }
+
+        StartThreads();
+        return true;
     }
 
-    void Service::Listen(uint16_t port)
+    bool Service::ListenTcp(const std::string& address, uint16_t port)
     {
+        websocketpp::lib::asio::error_code ec;
+        auto ipAddress = websocketpp::lib::asio::ip::address::from_string(address, ec);
+        if (ec)
+        {
+            std::cerr << "Failed to start server: invalid address " << address << std::endl;
+            return false;
+        }
+
         try
         {
-            m_server.listen(9229);
+            m_server.listen(websocketpp::lib::asio::ip::tcp::endpoint(ipAddress, port));
             m_server.start_accept();
         }
         catch (const websocketpp::exception& e)
         {
             std::cerr << "Failed to start server: " << e.what() << std::endl;
+            return false;
+        }
+
+        StartThreads();
+        return true;
+    }
+
+    bool Service::ListenLocal(const std::string& path)
+    {
+#ifdef JSDEBUG_HAS_LOCAL_SOCKETS
+        auto listener = std::make_unique<LocalListener>(&m_server);
+
+        std::string error;
+        if (!listener->Listen(path, &error))
+        {
+            std::cerr << "Failed to listen on " << path << ": " << error << std::endl;
+            return false;
+        }
+
+        m_localListeners.push_back(std::move(listener));
+
+        StartThreads();
+        return true;
+#else
+        std::cerr << "Failed to listen on " << path << ": local sockets aren't supported on this platform" << std::endl;
+        return false;
+#endif
+    }
+
+    bool Service::SupportsLocalSockets()
+    {
+#ifdef JSDEBUG_HAS_LOCAL_SOCKETS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void Service::StartThreads()
+    {
+        // The threads run until nothing is listening and every connection is closed, so further listeners share them.
+        if (!m_threads.empty())
+        {
+            return;
         }
 
-        m_thread = thread(&server::run, &m_server);
+        // Every connection has its own strand, so its handlers never run concurrently whichever thread they run on.
+        for (size_t i = 0; i < m_ioThreadCount; i++)
+        {
+            m_threads.emplace_back(&server::run, &m_server);
+        }
     }
 
     void Service::Close()
     {
         try
         {
-            // Stop listening for new connections
-            m_server.stop_listening();
+            // Stop listening for new connections. The server itself might only have had local listeners.
+            websocketpp::lib::error_code ec;
+            m_server.stop_listening(ec);
+
+#ifdef JSDEBUG_HAS_LOCAL_SOCKETS
+            for (const auto& listener : m_localListeners)
+            {
+                listener->Close();
+            }
+#endif
 
             {
                 unique_lock<mutex> lock(m_lock);
@@ -97,9 +606,151 @@ namespace JsDebug
             std::cerr << "Failed to stop server: " << e.what() << std::endl;
         }
 
-        // Wait for the thread to exit
-        if (m_thread.joinable()) {
-            m_thread.join();
+        // Wait for the threads to exit
+        for (auto& thread : m_threads)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+
+        m_threads.clear();
+
+#ifdef JSDEBUG_HAS_LOCAL_SOCKETS
+        m_localListeners.clear();
+#endif
+    }
+
+    std::shared_ptr<const Service::Registry> Service::GetRegistry() const
+    {
+        return std::atomic_load(&m_registry);
+    }
+
+    void Service::PublishRegistry(handler_map handlers)
+    {
+        auto registry = std::make_shared<Registry>();
+        registry->handlers = std::move(handlers);
+        RenderDiscoveryDocuments(registry->handlers, &registry->discovery);
+
+        std::atomic_store(&m_registry, std::shared_ptr<const Registry>(std::move(registry)));
+    }
+
+    void Service::RenderDiscoveryDocuments(const handler_map& handlers, DiscoveryDocuments* documents)
+    {
+        std::string part = "[";
+
+        for (const auto& handler : handlers)
+        {
+            if (part.back() != '[')
+            {
+                part.push_back(',');
+            }
+
+            part.append("{\"description\":\"ChakraCore instance\",\"devtoolsFrontendUrl\":\"");
+            part.append("chrome-devtools://devtools/bundled/inspector.html?experiments=true&v8only=true&ws=");
+            documents->listParts.push_back(std::move(part));
+
+            std::string path = "/" + PercentEncode(handler.first);
+
+            part.clear();
+            AppendJsonEscaped(&part, path);
+            part.append("\",\"id\":");
+            AppendJsonString(&part, handler.first);
+            part.append(",\"title\":");
+            AppendJsonString(&part, handler.first);
+            part.append(",\"type\":\"node\",\"url\":\"\",\"webSocketDebuggerUrl\":\"ws://");
+            documents->listParts.push_back(std::move(part));
+
+            part.clear();
+            AppendJsonEscaped(&part, path);
+            part.append("\"}");
+        }
+
+        part.push_back(']');
+        documents->listParts.push_back(std::move(part));
+    }
+
+    void Service::OnHttp(connection_hdl hdl)
+    {
+        auto connection = m_server.get_con_from_hdl(hdl);
+        const std::string& resource = connection->get_uri()->get_resource();
+        std::string path = resource.substr(0, resource.find('?'));
+
+        if (path == "/json" || path == "/json/list")
+        {
+            std::string host = connection->get_request_header("Host");
+            if (!IsValidHost(host))
+            {
+                host = kDefaultHost;
+            }
+
+            auto registry = GetRegistry();
+
+            std::string body;
+            for (const auto& part : registry->discovery.listParts)
+            {
+                if (!body.empty())
+                {
+                    body.append(host);
+                }
+
+                body.append(part);
+            }
+
+            connection->set_status(websocketpp::http::status_code::ok);
+            connection->append_header("Content-Type", kJsonContentType);
+            connection->set_body(body);
+        }
+        else if (path == "/json/version")
+        {
+            std::string body = "{\"Browser\":\"ChakraCore-Debugger\",\"Protocol-Version\":\"";
+            body.append(protocol::kProtocolVersion);
+            body.append("\"}");
+
+            connection->set_status(websocketpp::http::status_code::ok);
+            connection->append_header("Content-Type", kJsonContentType);
+            connection->set_body(body);
+        }
+        else if (path == "/json/protocol")
+        {
+            connection->append_header("ETag", protocol::kProtocolJsonETag);
+
+            if (connection->get_request_header("If-None-Match") == protocol::kProtocolJsonETag)
+            {
+                connection->set_status(websocketpp::http::status_code::not_modified);
+                return;
+            }
+
+            connection->set_status(websocketpp::http::status_code::ok);
+            connection->append_header("Content-Type", kJsonContentType);
+            connection->append_header("Vary", "Accept-Encoding");
+
+            if (HeaderContains(connection->get_request_header("Accept-Encoding"), "gzip"))
+            {
+                connection->append_header("Content-Encoding", "gzip");
+                connection->set_body(std::string(
+                    reinterpret_cast<const char*>(protocol::kProtocolJsonGzip),
+                    sizeof(protocol::kProtocolJsonGzip)));
+            }
+            else
+            {
+                connection->set_body(GetProtocolJson());
+            }
+        }
+        else if (path.compare(0, 15, "/json/activate/") == 0)
+        {
+            auto registry = GetRegistry();
+            bool found = registry->handlers.count(path.substr(15)) != 0;
+
+            connection->set_status(
+                found ? websocketpp::http::status_code::ok : websocketpp::http::status_code::not_found);
+            connection->append_header("Content-Type", "text/plain");
+            connection->set_body(found ? "Target activated" : "No such target id: " + path.substr(15));
+        }
+        else
+        {
+            connection->set_status(websocketpp::http::status_code::not_found);
         }
     }
 
@@ -110,19 +761,61 @@ namespace JsDebug
             auto resource = connection->get_uri()->get_resource();
             resource.erase(0, 1);
 
+            if (resource.empty())
             {
                 unique_lock<mutex> lock(m_lock);
 
-                auto handler = m_handlers.find(resource);
-                if (handler == m_handlers.end()) {
-                    return false;
-                }
+                auto sessions = std::make_shared<SessionConnection>();
+                sessions->queue = std::make_shared<OutboundQueue>(m_queueLimits);
+                connection->set_message_handler(bind(&Service::OnSessionMessage, this, sessions, _1, _2));
+                connection->set_close_handler(bind(&Service::OnSessionClose, this, sessions, _1));
 
-                if (handler->second->RegisterConnection(hdl))
+                m_connections.insert(hdl);
+                return true;
+            }
+
+            // "/<id>?observer" attaches a read-only connection to the handler, and "encoding=cbor" has the connection
+            // use binary messages. Parameters can be combined with '&'.
+            bool observer = false;
+            bool cbor = false;
+            size_t query = resource.find('?');
+            if (query != std::string::npos)
+            {
+                for (size_t start = query + 1; start <= resource.length();)
                 {
-                    m_connections.insert(hdl);
-                    return true;
+                    size_t end = resource.find('&', start);
+                    if (end == std::string::npos)
+                    {
+                        end = resource.length();
+                    }
+
+                    std::string parameter = resource.substr(start, end - start);
+                    observer = observer || parameter == "observer";
+                    cbor = cbor || parameter == "encoding=cbor";
+                    start = end + 1;
                 }
+
+                resource.erase(query);
+            }
+
+            std::string id;
+            if (!PercentDecode(resource, &id))
+            {
+                return false;
+            }
+
+            auto registry = GetRegistry();
+
+            auto handler = registry->handlers.find(id);
+            if (handler == registry->handlers.end()) {
+                return false;
+            }
+
+            if (handler->second->RegisterConnection(hdl, observer, cbor))
+            {
+                unique_lock<mutex> lock(m_lock);
+                m_connections.insert(hdl);
+                return true;
             }
         }
 
@@ -134,4 +827,194 @@ namespace JsDebug
         unique_lock<mutex> lock(m_lock);
         m_connections.erase(hdl);
     }
+
+    void Service::OnSessionMessage(
+        const std::shared_ptr<SessionConnection>& connection,
+        connection_hdl hdl,
+        server::message_ptr msg)
+    {
+        const std::string& payload = msg->get_payload();
+
+        // Commands for a session are passed on as they are, so only the fields they're routed by are read here.
+        SessionCommand command = {};
+        SessionCommandReader reader(&command);
+        // Without a usable id the error can't be matched to a command, so it is reported against a null one.
+        if (!JsonReader::Read(payload.data(), payload.length(), &reader))
+        {
+            SendSessionReply(connection.get(), hdl, MakeError("null", -32700, "Message must be a valid JSON"));
+            return;
+        }
+
+        if (!command.hasId)
+        {
+            SendSessionReply(
+                connection.get(),
+                hdl,
+                MakeError("null", -32600, "Message must have integer 'id' property"));
+            return;
+        }
+
+        int id = command.id;
+
+        if (command.hasSessionId)
+        {
+            const std::string& session = command.sessionId;
+
+            auto it = connection->sessions.find(session);
+            if (it != connection->sessions.end())
+            {
+                auto handler = it->second.lock();
+                if (handler != nullptr && !handler->IsClosed())
+                {
+                    handler->SendSessionCommand(session, payload.c_str());
+                    return;
+                }
+
+                connection->sessions.erase(it);
+            }
+
+            SendSessionReply(connection.get(), hdl, MakeError(id, -32001, "Session with given id not found."));
+            return;
+        }
+
+        const std::string& method = command.method;
+
+        // The connection's own commands are few and far between, so the ones with params get a full parse.
+        std::unique_ptr<protocol::Value> value;
+        protocol::DictionaryValue* params = nullptr;
+        if (method == "Target.attachToTarget" || method == "Target.detachFromTarget")
+        {
+            value = protocol::parseJSONCharacters(
+                reinterpret_cast<const uint8_t*>(payload.data()),
+                static_cast<unsigned int>(payload.length()));
+
+            protocol::DictionaryValue* message = protocol::DictionaryValue::cast(value.get());
+            params = message != nullptr ? message->getObject("params") : nullptr;
+        }
+
+        String16 param;
+
+        std::string response;
+        if (method == "Target.getTargets")
+        {
+            response = MakeResult(id, GetTargets());
+        }
+        else if (method == "Target.attachToTarget" && params != nullptr && params->getString("targetId", &param))
+        {
+            std::string session = AttachToTarget(connection.get(), hdl, param.toUTF8());
+            if (session.empty())
+            {
+                response = MakeError(id, -32602, "No target with given id found");
+            }
+            else
+            {
+                std::string result = "{\"sessionId\":";
+                AppendJsonString(&result, session);
+                result.push_back('}');
+                response = MakeResult(id, result);
+            }
+        }
+        else if (method == "Target.detachFromTarget" && params != nullptr && params->getString("sessionId", &param))
+        {
+            response = DetachFromTarget(connection.get(), param.toUTF8())
+                ? MakeResult(id, "{}")
+                : MakeError(id, -32602, "No session with given id");
+        }
+        else
+        {
+            response = MakeError(id, -32601, "'" + method + "' wasn't found");
+        }
+
+        SendSessionReply(connection.get(), hdl, response);
+    }
+
+    void Service::OnSessionClose(const std::shared_ptr<SessionConnection>& connection, connection_hdl hdl)
+    {
+        for (const auto& session : connection->sessions)
+        {
+            auto handler = session.second.lock();
+            if (handler != nullptr)
+            {
+                handler->DetachSession(session.first);
+            }
+        }
+
+        connection->sessions.clear();
+        OnClose(hdl);
+    }
+
+    std::string Service::AttachToTarget(SessionConnection* connection, connection_hdl hdl, const std::string& targetId)
+    {
+        std::shared_ptr<ServiceHandler> handler;
+
+        {
+            auto registry = GetRegistry();
+
+            auto it = registry->handlers.find(targetId);
+            if (it == registry->handlers.end())
+            {
+                return std::string();
+            }
+
+            handler = it->second;
+        }
+
+        std::string sessionId = std::to_string(++m_nextSessionId);
+        if (!handler->AttachSession(hdl, sessionId, connection->queue))
+        {
+            return std::string();
+        }
+
+        connection->sessions.emplace(sessionId, handler);
+
+        return sessionId;
+    }
+
+    bool Service::DetachFromTarget(SessionConnection* connection, const std::string& sessionId)
+    {
+        auto it = connection->sessions.find(sessionId);
+        if (it == connection->sessions.end())
+        {
+            return false;
+        }
+
+        auto handler = it->second.lock();
+        if (handler != nullptr)
+        {
+            handler->DetachSession(sessionId);
+        }
+
+        connection->sessions.erase(it);
+        return true;
+    }
+
+    void Service::SendSessionReply(SessionConnection* connection, connection_hdl hdl, const std::string& reply)
+    {
+        ServiceHandler::QueueReply(&m_server, hdl, connection->queue, reply.data(), reply.length());
+    }
+
+    std::string Service::GetTargets()
+    {
+        auto registry = GetRegistry();
+        std::string result = "{\"targetInfos\":[";
+
+        for (const auto& handler : registry->handlers)
+        {
+            if (result.back() != '[')
+            {
+                result.push_back(',');
+            }
+
+            result.append("{\"targetId\":");
+            AppendJsonString(&result, handler.first);
+            result.append(",\"type\":\"node\",\"title\":");
+            AppendJsonString(&result, handler.first);
+            result.append(",\"url\":\"\",\"attached\":");
+            result.append(handler.second->IsAttached() ? "true" : "false");
+            result.push_back('}');
+        }
+
+        result.append("]}");
+        return result;
+    }
 }
\ No newline at end of file
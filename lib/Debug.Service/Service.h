@@ -10,13 +10,20 @@
 #define ASIO_STANDALONE
 #define _WEBSOCKETPP_CPP11_TYPE_TRAITS_
 #include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
 #include <websocketpp/server.hpp>
 #pragma warning( pop )
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <ChakraDebugProtocolHandler.h>
+#include "LocalListener.h"
 #include "ServiceHandler.h"
 
 namespace JsDebug
@@ -30,23 +37,102 @@ namespace JsDebug
         void RegisterHandler(const char* id, JsDebugProtocolHandler protocolHandler, bool breakOnNextLine);
         void UnregisterHandler(const char* id);
 
-        void Listen(uint16_t port);
+        // Only takes effect if called before Listen.
+        void SetIoThreadCount(size_t count);
+
+        // Applies to connections made after the call.
+        void SetOutboundQueueLimits(const OutboundQueueLimits& limits);
+
+        // Applies to handlers registered after the call.
+        void SetCompression(const CompressionSettings& compression);
+
+        // Each returns false if the service couldn't listen as asked. The server can only listen on one TCP endpoint,
+        // but any number of local sockets.
+        bool Listen(uint16_t port);
+        bool ListenTcp(const std::string& address, uint16_t port);
+        bool ListenLocal(const std::string& path);
+        static bool SupportsLocalSockets();
+
         void Close();
 
     private:
+        typedef std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>> con_list;
+        typedef std::map<std::string, std::shared_ptr<ServiceHandler>> handler_map;
+        typedef std::unordered_map<std::string, std::weak_ptr<ServiceHandler>> session_map;
+
+        // The sessions attached through one multiplexed connection. Handlers for a connection run on its strand, so
+        // this is only ever accessed by one thread at a time and needs no lock.
+        struct SessionConnection
+        {
+            session_map sessions;
+
+            // Everything sent on the connection goes through this, whichever session it's for, as do the replies to
+            // the connection's own commands.
+            std::shared_ptr<OutboundQueue> queue;
+        };
+
+        // The documents served by the HTTP discovery endpoints, rendered whenever the set of handlers changes so that
+        // polling them costs next to nothing.
+        struct DiscoveryDocuments
+        {
+            // The target list, with the host the request was made to going in between each of the parts.
+            std::vector<std::string> listParts;
+        };
+
+        // The handlers and everything derived from them. A registry is never changed once it has been published;
+        // registering or unregistering a handler publishes a modified copy, so lookups never wait for either.
+        struct Registry
+        {
+            handler_map handlers;
+            DiscoveryDocuments discovery;
+        };
+
+        std::shared_ptr<const Registry> GetRegistry() const;
+        void PublishRegistry(handler_map handlers);
+        static void RenderDiscoveryDocuments(const handler_map& handlers, DiscoveryDocuments* documents);
+
+        void OnHttp(websocketpp::connection_hdl hdl);
+
         bool OnValidate(websocketpp::connection_hdl hdl);
         void OnClose(websocketpp::connection_hdl hdl);
 
-        typedef std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>> con_list;
-        typedef std::map<std::string, std::unique_ptr<ServiceHandler>> handler_map;
+        // Connections to the root path carry messages for any number of handlers, tagged with a session id.
+        void OnSessionMessage(
+            const std::shared_ptr<SessionConnection>& connection,
+            websocketpp::connection_hdl hdl,
+            websocketpp::server<ServiceConfig>::message_ptr msg);
+        void OnSessionClose(const std::shared_ptr<SessionConnection>& connection, websocketpp::connection_hdl hdl);
+        std::string AttachToTarget(
+            SessionConnection* connection,
+            websocketpp::connection_hdl hdl,
+            const std::string& targetId);
+        bool DetachFromTarget(SessionConnection* connection, const std::string& sessionId);
+        void SendSessionReply(SessionConnection* connection, websocketpp::connection_hdl hdl, const std::string& reply);
+        std::string GetTargets();
+
+        void StartThreads();
 
         // Although access to the server object is thread-safe, access to all other objects is not. The lock must be
-        // taken before accessing any class members from either thread.
-        websocketpp::server<websocketpp::config::asio> m_server;
-        websocketpp::lib::thread m_thread;
+        // taken before accessing any class members from any of the I/O threads, but isn't needed to route messages or
+        // to look up handlers.
+        websocketpp::server<ServiceConfig> m_server;
+        std::vector<websocketpp::lib::thread> m_threads;
+        size_t m_ioThreadCount;
+        OutboundQueueLimits m_queueLimits;
+        CompressionSettings m_compression;
         websocketpp::lib::mutex m_lock;
 
         con_list m_connections;
-        handler_map m_handlers;
+
+        // Read with atomic_load and without any lock. Writers serialize on the registry lock, which is never taken by
+        // the I/O threads.
+        std::shared_ptr<const Registry> m_registry;
+        websocketpp::lib::mutex m_registryLock;
+
+        std::atomic<uint64_t> m_nextSessionId;
+
+#ifdef JSDEBUG_HAS_LOCAL_SOCKETS
+        std::vector<std::unique_ptr<LocalListener>> m_localListeners;
+#endif
     };
 }
@@ -0,0 +1,56 @@
+//---------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace JsDebug
+{
+    // The server side of permessage-deflate. Messages are compressed once and then sent on every connection that
+    // accepts compression, so the compressor has to start afresh for each message rather than reuse the window of the
+    // ones before it.
+    template <typename config>
+    class ServerDeflateExtension : public websocketpp::extensions::permessage_deflate::enabled<config>
+    {
+    public:
+        ServerDeflateExtension()
+        {
+            this->enable_server_no_context_takeover();
+        }
+    };
+
+    struct ServiceConfig : public websocketpp::config::asio
+    {
+        typedef ServiceConfig type;
+        typedef websocketpp::config::asio base;
+
+        typedef base::concurrency_type concurrency_type;
+        typedef base::request_type request_type;
+        typedef base::response_type response_type;
+        typedef base::message_type message_type;
+        typedef base::con_msg_manager_type con_msg_manager_type;
+        typedef base::endpoint_msg_manager_type endpoint_msg_manager_type;
+        typedef base::alog_type alog_type;
+        typedef base::elog_type elog_type;
+        typedef base::rng_type rng_type;
+
+        struct transport_config : public base::transport_config
+        {
+            typedef type::concurrency_type concurrency_type;
+            typedef type::alog_type alog_type;
+            typedef type::elog_type elog_type;
+            typedef type::request_type request_type;
+            typedef type::response_type response_type;
+            typedef websocketpp::transport::asio::basic_socket::endpoint socket_type;
+        };
+
+        typedef websocketpp::transport::asio::endpoint<transport_config> transport_type;
+
+        struct permessage_deflate_config
+        {
+        };
+
+        typedef ServerDeflateExtension<permessage_deflate_config> permessage_deflate_type;
+    };
+}
@@ -1,51 +1,453 @@
 #include "stdafx.h"
 #include "ServiceHandler.h"
 
+#include <Cbor.h>
+#include <JsonReader.h>
+#include <protocol\Protocol.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
 namespace JsDebug
 {
-    typedef websocketpp::server<websocketpp::config::asio> server;
+    typedef websocketpp::server<ServiceConfig> server;
+    typedef ServiceConfig::message_type message_type;
+
+    namespace opcode = websocketpp::frame::opcode;
 
     using websocketpp::connection_hdl;
 
-    using websocketpp::lib::bind;
-    using websocketpp::lib::placeholders::_1;
-    using websocketpp::lib::placeholders::_2;
+    namespace
+    {
+        const char kNotificationPrefix[] = "{\"method\":";
+        const char kDebuggerNotificationPrefix[] = "{\"method\":\"Debugger.";
+
+        // How long to wait before trying again to hand queued messages to a connection that is still busy.
+        const long kQueueFlushRetryMilliseconds = 10;
+
+        // Responses larger than this are streamed to clients as fragmented messages.
+        const size_t kFragmentSize = 256 * 1024;
+
+        // Buffers reused from one message to the next are let go of when a message makes them grow past this.
+        const size_t kMaxRetainedBufferBytes = 1024 * 1024;
+
+        const char kObserverError[] =
+            "{\"id\":%d,\"error\":{\"code\":-32000,\"message\":\"Observer connections are read-only\"}}";
+
+        // Notifications are serialized with the method first, responses with the id first.
+        bool IsNotification(const char* message)
+        {
+            return std::strncmp(message, kNotificationPrefix, sizeof(kNotificationPrefix) - 1) == 0;
+        }
+
+        // Picks the top-level id out of a command without building a Value tree for it.
+        class MessageIdReader : public JsonReader::Handler
+        {
+        public:
+            explicit MessageIdReader(int* id)
+                : m_id(id)
+                , m_found(false)
+                , m_depth(0)
+                , m_isIdValue(false)
+            {
+            }
+
+            bool Found() const
+            {
+                return m_found;
+            }
+
+            bool OnObjectStart() override
+            {
+                m_isIdValue = false;
+                m_depth++;
+                return true;
+            }
+
+            bool OnObjectEnd() override
+            {
+                m_depth--;
+                return true;
+            }
+
+            bool OnArrayStart() override
+            {
+                m_isIdValue = false;
+                m_depth++;
+                return true;
+            }
+
+            bool OnArrayEnd() override
+            {
+                m_depth--;
+                return true;
+            }
+
+            bool OnKey(const char* key, size_t length) override
+            {
+                m_isIdValue = m_depth == 1 && length == 2 && std::memcmp(key, "id", 2) == 0;
+                return true;
+            }
+
+            bool OnString(const char* str, size_t length) override
+            {
+                m_isIdValue = false;
+                return true;
+            }
+
+            bool OnInteger(int32_t value) override
+            {
+                if (m_isIdValue)
+                {
+                    *m_id = value;
+                    m_found = true;
+                }
+
+                m_isIdValue = false;
+                return true;
+            }
+
+            bool OnDouble(double value) override
+            {
+                m_isIdValue = false;
+                return true;
+            }
+
+            bool OnBool(bool value) override
+            {
+                m_isIdValue = false;
+                return true;
+            }
+
+            bool OnNull() override
+            {
+                m_isIdValue = false;
+                return true;
+            }
+
+        private:
+            int* m_id;
+            bool m_found;
+            int m_depth;
+            bool m_isIdValue;
+        };
+
+        bool TryGetMessageId(const char* message, size_t length, int* id)
+        {
+            MessageIdReader reader(id);
+            return JsonReader::Read(message, length, &reader) && reader.Found();
+        }
+
+        bool TryGetCborMessageId(const std::string& message, int* id)
+        {
+            std::unique_ptr<protocol::Value> value = Cbor::Parse(
+                reinterpret_cast<const uint8_t*>(message.data()),
+                message.length());
+            protocol::DictionaryValue* object = protocol::DictionaryValue::cast(value.get());
+
+            return object != nullptr && object->getInteger("id", id);
+        }
+
+        // Responses and Debugger events (pauses, scripts, breakpoints) are what the frontend can't work without, so
+        // they are sent ahead of everything else. The rest is console output and the like, which can be lost if the
+        // client can't keep up.
+        bool IsEssential(const char* message)
+        {
+            return !IsNotification(message) ||
+                std::strncmp(message, kDebuggerNotificationPrefix, sizeof(kDebuggerNotificationPrefix) - 1) == 0;
+        }
+
+        void ReleaseIfLarge(std::string* buffer)
+        {
+            if (buffer->capacity() > kMaxRetainedBufferBytes)
+            {
+                std::string().swap(*buffer);
+            }
+        }
+
+        // Adds the session id as the first property of a serialized message.
+        std::string AddSessionId(const std::string& sessionId, const char* message, size_t length)
+        {
+            std::string result;
+            result.reserve(length + sessionId.length() + 16);
+            result.append("{\"sessionId\":\"");
+            result.append(sessionId);
+            result.append("\",");
+            result.append(message + 1, length - 1);
+            return result;
+        }
+
+        // Messages are compressed with the full window, which a client that asked to limit it can't take.
+        bool AcceptsCompression(const server::connection_ptr& connection)
+        {
+            const std::string& extensions = connection->get_response_header("Sec-WebSocket-Extensions");
+            return extensions.find("permessage-deflate") != std::string::npos &&
+                extensions.find("server_max_window_bits") == std::string::npos;
+        }
+
+        void PrepareHeader(const message_type::ptr& message, opcode::value op, bool final, bool compressed)
+        {
+            size_t length = message->get_payload().length();
+
+            // Server frames aren't masked, so the same header is valid on every connection and the connection doesn't
+            // need to prepare the message again.
+            websocketpp::frame::basic_header header(op, length, final, false, compressed);
+            websocketpp::frame::extended_header extendedHeader(length);
+            message->set_header(websocketpp::frame::prepare_header(header, extendedHeader));
+            message->set_prepared(true);
+        }
+
+        message_type::ptr PrepareFrame(
+            const char* payload,
+            size_t length,
+            opcode::value op,
+            bool final,
+            bool compressed)
+        {
+            auto message = websocketpp::lib::make_shared<message_type>(message_type::con_msg_man_ptr(), op, length);
+            message->set_payload(payload, length);
+            PrepareHeader(message, op, final, compressed);
+
+            return message;
+        }
+
+        message_type::ptr PrepareMessage(const char* payload, size_t length, bool compressed = false)
+        {
+            return PrepareFrame(payload, length, opcode::text, true, compressed);
+        }
+    }
 
     ServiceHandler::ServiceHandler(
         server* server,
         const char* id,
         JsDebugProtocolHandler protocolHandler,
-        bool breakOnNextLine)
+        bool breakOnNextLine,
+        const OutboundQueueLimits& queueLimits,
+        const CompressionSettings& compression)
         : m_server(server)
         , m_id(id)
-        , m_protocolHandler(protocolHandler)
         , m_breakOnNextLine(breakOnNextLine)
+        , m_protocolHandler(protocolHandler)
+        , m_deflater(compression)
+        , m_closed(false)
+        , m_queueLimits(queueLimits)
+        , m_fragmentedMessage()
     {
         JsDebugProtocolHandlerConnect(
             m_protocolHandler,
             m_breakOnNextLine,
             &ServiceHandler::SendResponseCallback,
             this);
+        JsDebugProtocolHandlerSetFlushCallback(m_protocolHandler, &ServiceHandler::FlushCallback);
+        JsDebugProtocolHandlerSetFragmentCallback(
+            m_protocolHandler,
+            &ServiceHandler::SendFragmentCallback,
+            kFragmentSize);
     }
 
     ServiceHandler::~ServiceHandler()
     {
+        Close();
+    }
+
+    const std::string& ServiceHandler::Id() const
+    {
+        return m_id;
+    }
+
+    void ServiceHandler::Close()
+    {
+        std::vector<Client> clients;
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            if (m_closed)
+            {
+                return;
+            }
+
+            m_closed = true;
+
+            if (!m_controller.hdl.expired())
+            {
+                clients.push_back(m_controller);
+            }
+
+            clients.insert(clients.end(), m_observers.begin(), m_observers.end());
+            m_controller = Client();
+            m_observers.clear();
+        }
+
+        // Sessions share their connection with other handlers, so only connections of the handler's own are closed.
+        // Sessions find out the next time they send a command.
+        for (const auto& client : clients)
+        {
+            if (client.sessionId.empty())
+            {
+                websocketpp::lib::error_code ec;
+                client.queue->Clear();
+                m_server->close(client.hdl, websocketpp::close::status::going_away, "Target closed", ec);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(m_protocolHandlerLock);
         JsDebugProtocolHandlerDisconnect(m_protocolHandler);
+        m_protocolHandler = nullptr;
     }
 
-    bool ServiceHandler::RegisterConnection(connection_hdl hdl)
+    bool ServiceHandler::IsClosed() const
     {
-        if (!m_hdl.expired()) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        return m_closed;
+    }
+
+    void ServiceHandler::SetOutboundQueueLimits(const OutboundQueueLimits& queueLimits)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_queueLimits = queueLimits;
+    }
+
+    bool ServiceHandler::RegisterConnection(connection_hdl hdl, bool observer, bool cbor)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (m_closed)
+        {
             return false;
         }
 
         auto connection = m_server->get_con_from_hdl(hdl);
-        connection->set_message_handler(bind(&ServiceHandler::OnMessage, this, _1, _2));
 
-        m_hdl = hdl;
+        // The connection can outlive the handler, so its handlers only hold on to it weakly.
+        std::weak_ptr<ServiceHandler> weakThis = shared_from_this();
+
+        if (!observer && m_controller.hdl.expired())
+        {
+            connection->set_message_handler([weakThis](connection_hdl hdl, server::message_ptr msg)
+            {
+                auto handler = weakThis.lock();
+                if (handler != nullptr)
+                {
+                    handler->OnMessage(hdl, msg);
+                }
+            });
+        }
+        else
+        {
+            connection->set_message_handler([weakThis](connection_hdl hdl, server::message_ptr msg)
+            {
+                auto handler = weakThis.lock();
+                if (handler != nullptr)
+                {
+                    handler->OnObserverMessage(hdl, msg);
+                }
+            });
+
+            observer = true;
+        }
+
+        AddClient(hdl, std::string(), std::make_shared<OutboundQueue>(m_queueLimits), observer, cbor);
+        return true;
+    }
+
+    bool ServiceHandler::AttachSession(
+        connection_hdl hdl,
+        const std::string& sessionId,
+        std::shared_ptr<OutboundQueue> queue)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (m_closed)
+        {
+            return false;
+        }
+
+        AddClient(hdl, sessionId, std::move(queue), !m_controller.hdl.expired(), false);
         return true;
     }
 
+    void ServiceHandler::DetachSession(const std::string& sessionId)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        if (!m_controller.hdl.expired() && m_controller.sessionId == sessionId)
+        {
+            m_controller = Client();
+            return;
+        }
+
+        m_observers.erase(
+            std::remove_if(m_observers.begin(), m_observers.end(), [&sessionId](const Client& observer)
+            {
+                return observer.sessionId == sessionId;
+            }),
+            m_observers.end());
+    }
+
+    bool ServiceHandler::IsAttached() const
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        return !m_controller.hdl.expired();
+    }
+
+    bool ServiceHandler::SendSessionCommand(const std::string& sessionId, const char* command)
+    {
+        Client target = {};
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            if (!m_controller.hdl.expired() && m_controller.sessionId == sessionId)
+            {
+                lock.unlock();
+
+                std::unique_lock<std::mutex> protocolHandlerLock(m_protocolHandlerLock);
+                if (m_protocolHandler != nullptr)
+                {
+                    JsDebugProtocolHandlerSendCommand(m_protocolHandler, command);
+                }
+
+                return true;
+            }
+
+            for (const auto& observer : m_observers)
+            {
+                if (observer.sessionId == sessionId)
+                {
+                    target = observer;
+                }
+            }
+        }
+
+        int id = 0;
+        if (target.queue == nullptr || !TryGetMessageId(command, std::strlen(command), &id))
+        {
+            return false;
+        }
+
+        char error[sizeof(kObserverError) + 16];
+        int length = std::snprintf(error, sizeof(error), kObserverError, id);
+        std::string message = AddSessionId(sessionId, error, static_cast<size_t>(length));
+
+        QueueReply(m_server, target.hdl, target.queue, message.c_str(), message.length());
+        return false;
+    }
+
+    void ServiceHandler::QueueReply(
+        server* server,
+        connection_hdl hdl,
+        const std::shared_ptr<OutboundQueue>& queue,
+        const char* reply,
+        size_t length)
+    {
+        bool needsFlush = false;
+        queue->Push(PrepareMessage(reply, length), true, &needsFlush);
+
+        if (needsFlush)
+        {
+            ScheduleFlush(server, hdl, queue);
+        }
+    }
+
     void ServiceHandler::SendResponseCallback(const char* response, void* callbackState)
     {
         auto serviceHandler = static_cast<ServiceHandler*>(callbackState);
@@ -54,15 +456,384 @@ namespace JsDebug
 
     void ServiceHandler::SendResponse(const char* response)
     {
-        if (m_hdl.expired()) {
+        std::vector<Client> targets = GetTargets(IsNotification(response));
+        if (targets.empty())
+        {
             return;
         }
 
-        m_server->send(m_hdl, std::string(response), websocketpp::frame::opcode::text);
+        size_t length = std::strlen(response);
+        bool essential = IsEssential(response);
+
+        // The frame is built (and transcoded and compressed) once per form and the same buffers are queued on every
+        // connection of its own. Sessions each need their id added, so they get a copy.
+        message_type::ptr messages[2][2];
+
+        for (const auto& target : targets)
+        {
+            if (!target.sessionId.empty())
+            {
+                std::string sessionMessage = AddSessionId(target.sessionId, response, length);
+                Enqueue(target, PrepareMessageFor(target, sessionMessage.c_str(), sessionMessage.length()), essential);
+                continue;
+            }
+
+            message_type::ptr& shared = messages[target.cbor][target.compress];
+            if (shared == nullptr)
+            {
+                shared = PrepareMessageFor(target, response, length);
+            }
+
+            Enqueue(target, shared, essential);
+        }
+    }
+
+    void ServiceHandler::SendFragmentCallback(const char* fragment, size_t length, bool final, void* callbackState)
+    {
+        auto serviceHandler = static_cast<ServiceHandler*>(callbackState);
+        serviceHandler->SendFragment(fragment, length, final);
+    }
+
+    void ServiceHandler::SendFragment(const char* fragment, size_t length, bool final)
+    {
+        FragmentedMessage& message = m_fragmentedMessage;
+        bool first = !message.active;
+
+        if (first)
+        {
+            message.active = true;
+            message.essential = IsEssential(fragment);
+            message.compress = false;
+            message.compressedStarted = false;
+
+            for (const auto& target : GetTargets(IsNotification(fragment)))
+            {
+                if (target.sessionId.empty() && !target.cbor)
+                {
+                    message.compress = message.compress || (target.compress && m_deflater.IsEnabled());
+                    message.connections.push_back(target);
+                    continue;
+                }
+
+                message.wholeMessages.emplace_back(
+                    target,
+                    target.sessionId.empty()
+                        ? std::string(fragment, length)
+                        : AddSessionId(target.sessionId, fragment, length));
+            }
+        }
+        else
+        {
+            for (auto& whole : message.wholeMessages)
+            {
+                whole.second.append(fragment, length);
+            }
+        }
+
+        // Like whole messages, each frame is built (and compressed) once for all the connections. The compressor
+        // can hold on to its output, in which case compressed frames skip a turn.
+        message_type::ptr frame;
+        message_type::ptr compressedFrame;
+
+        if (message.compress)
+        {
+            std::string compressed;
+            m_deflater.CompressFragment(fragment, length, final, &compressed);
+
+            if (!compressed.empty() || final)
+            {
+                compressedFrame = PrepareFrame(
+                    compressed.data(),
+                    compressed.length(),
+                    message.compressedStarted ? opcode::continuation : opcode::text,
+                    final,
+                    !message.compressedStarted);
+                message.compressedStarted = true;
+            }
+        }
+
+        for (const auto& target : message.connections)
+        {
+            if (target.compress && message.compress)
+            {
+                if (compressedFrame != nullptr)
+                {
+                    EnqueueFragment(target, compressedFrame, final);
+                }
+
+                continue;
+            }
+
+            if (frame == nullptr)
+            {
+                frame = PrepareFrame(fragment, length, first ? opcode::text : opcode::continuation, final, false);
+            }
+
+            EnqueueFragment(target, frame, final);
+        }
+
+        if (final)
+        {
+            // Sessions can share a connection with other handlers, whose messages can't be sent in between the
+            // fragments, and CBOR can only be transcoded from a whole message, so those clients get it whole.
+            for (const auto& whole : message.wholeMessages)
+            {
+                Enqueue(
+                    whole.first,
+                    PrepareMessageFor(whole.first, whole.second.data(), whole.second.length()),
+                    message.essential);
+            }
+
+            m_fragmentedMessage = FragmentedMessage();
+        }
+
+        // Fragments go out as they are produced rather than waiting for the end of the batch.
+        Flush();
+    }
+
+    void ServiceHandler::FlushCallback(void* callbackState)
+    {
+        auto serviceHandler = static_cast<ServiceHandler*>(callbackState);
+        serviceHandler->Flush();
+    }
+
+    void ServiceHandler::Flush()
+    {
+        std::vector<Client> unflushed;
+        std::swap(m_unflushed, unflushed);
+
+        for (const auto& client : unflushed)
+        {
+            ScheduleFlush(m_server, client.hdl, client.queue);
+        }
     }
 
     void ServiceHandler::OnMessage(connection_hdl hdl, server::message_ptr msg)
     {
-        JsDebugProtocolHandlerSendCommand(m_protocolHandler, msg->get_payload().c_str());
+        const std::string& payload = msg->get_payload();
+
+        std::unique_lock<std::mutex> lock(m_protocolHandlerLock);
+        if (m_protocolHandler == nullptr)
+        {
+            return;
+        }
+
+        if (msg->get_opcode() == opcode::binary)
+        {
+            JsDebugProtocolHandlerSendCborCommand(
+                m_protocolHandler,
+                reinterpret_cast<const uint8_t*>(payload.data()),
+                payload.length());
+            return;
+        }
+
+        JsDebugProtocolHandlerSendCommand(m_protocolHandler, payload.c_str());
+    }
+
+    void ServiceHandler::OnObserverMessage(connection_hdl hdl, server::message_ptr msg)
+    {
+        const std::string& payload = msg->get_payload();
+        bool cbor = msg->get_opcode() == opcode::binary;
+
+        int id = 0;
+        if (cbor ? !TryGetCborMessageId(payload, &id) : !TryGetMessageId(payload.data(), payload.length(), &id))
+        {
+            return;
+        }
+
+        std::shared_ptr<OutboundQueue> queue;
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            for (const auto& observer : m_observers)
+            {
+                if (!observer.hdl.owner_before(hdl) && !hdl.owner_before(observer.hdl))
+                {
+                    queue = observer.queue;
+                }
+            }
+        }
+
+        if (queue == nullptr)
+        {
+            return;
+        }
+
+        char error[sizeof(kObserverError) + 16];
+        int length = std::snprintf(error, sizeof(error), kObserverError, id);
+
+        // The reply is in the encoding of the command. This runs on the server thread, so it isn't compressed.
+        std::string binary;
+        message_type::ptr reply = cbor && Cbor::FromJson(error, static_cast<size_t>(length), &binary)
+            ? PrepareFrame(binary.data(), binary.length(), opcode::binary, true, false)
+            : PrepareMessage(error, static_cast<size_t>(length));
+
+        // The reply goes through the queue so that it can't end up between the fragments of a notification.
+        bool needsFlush = false;
+        queue->Push(std::move(reply), true, &needsFlush);
+
+        if (needsFlush)
+        {
+            ScheduleFlush(m_server, hdl, queue);
+        }
+    }
+
+    message_type::ptr ServiceHandler::PrepareMessageFor(const Client& client, const char* payload, size_t length)
+    {
+        opcode::value op = opcode::text;
+        if (client.cbor)
+        {
+            m_transcoded.clear();
+            if (Cbor::FromJson(payload, length, &m_transcoded))
+            {
+                payload = m_transcoded.data();
+                length = m_transcoded.length();
+                op = opcode::binary;
+            }
+        }
+
+        message_type::ptr message = client.compress && m_deflater.Compress(payload, length, &m_compressed)
+            ? PrepareFrame(m_compressed.data(), m_compressed.length(), op, true, true)
+            : PrepareFrame(payload, length, op, true, false);
+
+        ReleaseIfLarge(&m_transcoded);
+        ReleaseIfLarge(&m_compressed);
+        return message;
+    }
+
+    std::vector<ServiceHandler::Client> ServiceHandler::GetTargets(bool notification) const
+    {
+        std::vector<Client> targets;
+
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        if (!m_controller.hdl.expired())
+        {
+            targets.push_back(m_controller);
+        }
+
+        if (notification)
+        {
+            for (const auto& observer : m_observers)
+            {
+                if (!observer.hdl.expired())
+                {
+                    targets.push_back(observer);
+                }
+            }
+        }
+
+        return targets;
+    }
+
+    void ServiceHandler::AddClient(
+        connection_hdl hdl,
+        const std::string& sessionId,
+        std::shared_ptr<OutboundQueue> queue,
+        bool observer,
+        bool cbor)
+    {
+        websocketpp::lib::error_code ec;
+        auto connection = m_server->get_con_from_hdl(hdl, ec);
+
+        Client client = {
+            hdl,
+            sessionId,
+            std::move(queue),
+            !ec && AcceptsCompression(connection),
+            cbor };
+
+        if (!observer)
+        {
+            m_controller = std::move(client);
+            return;
+        }
+
+        PruneObservers();
+        m_observers.push_back(std::move(client));
+    }
+
+    void ServiceHandler::PruneObservers()
+    {
+        // Drop observers that have gone away since the last one was added.
+        m_observers.erase(
+            std::remove_if(m_observers.begin(), m_observers.end(), [](const Client& observer)
+            {
+                return observer.hdl.expired();
+            }),
+            m_observers.end());
+    }
+
+    void ServiceHandler::Enqueue(const Client& client, message_type::ptr message, bool essential)
+    {
+        bool needsFlush = false;
+        OutboundQueue::PushResult result = client.queue->Push(std::move(message), essential, &needsFlush);
+
+        if (result == OutboundQueue::PushResult::Overflow)
+        {
+            // Closing a shared connection takes every session on it down, which is still better than letting one
+            // client stall everyone's memory budget.
+            websocketpp::lib::error_code ec;
+            client.queue->Clear();
+            m_server->close(client.hdl, websocketpp::close::status::try_again_later, "Outbound queue overflow", ec);
+            return;
+        }
+
+        // The queue only asks once until it has been flushed, so holding the request until the end of the batch
+        // lets the whole batch reach the connection in one go.
+        if (needsFlush)
+        {
+            m_unflushed.push_back(client);
+        }
+    }
+
+    void ServiceHandler::EnqueueFragment(const Client& client, message_type::ptr frame, bool final)
+    {
+        bool needsFlush = false;
+        client.queue->PushFragment(std::move(frame), final, &needsFlush);
+
+        if (needsFlush)
+        {
+            m_unflushed.push_back(client);
+        }
+    }
+
+    void ServiceHandler::ScheduleFlush(server* server, connection_hdl hdl, std::shared_ptr<OutboundQueue> queue)
+    {
+        websocketpp::lib::error_code ec;
+        auto connection = server->get_con_from_hdl(hdl, ec);
+        if (ec)
+        {
+            queue->Clear();
+            return;
+        }
+
+        // Flushing on the connection's strand keeps it in order with the connection's own handlers.
+        connection->get_strand()->post([server, hdl, queue]()
+        {
+            FlushQueue(server, hdl, queue);
+        });
+    }
+
+    void ServiceHandler::FlushQueue(server* server, connection_hdl hdl, std::shared_ptr<OutboundQueue> queue)
+    {
+        websocketpp::lib::error_code ec;
+        auto connection = server->get_con_from_hdl(hdl, ec);
+        if (ec)
+        {
+            queue->Clear();
+            return;
+        }
+
+        // Only a connection that is still over the watermark leaves messages behind, so there's nothing to do but
+        // check again shortly.
+        if (queue->Flush(connection))
+        {
+            server->set_timer(kQueueFlushRetryMilliseconds, [server, hdl, queue](const websocketpp::lib::error_code&)
+            {
+                ScheduleFlush(server, hdl, queue);
+            });
+        }
     }
 }
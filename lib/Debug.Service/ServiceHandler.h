@@ -1,33 +1,166 @@
 #pragma once
 
 #include <ChakraDebugProtocolHandler.h>
+#include "MessageDeflater.h"
+#include "OutboundQueue.h"
+
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace JsDebug
 {
-    class ServiceHandler
+    //
+    // Connects a protocol handler to the clients debugging it. Connections and queued work only hold weak references,
+    // so the handler can be closed while they're still around; after Close it never touches the protocol handler
+    // again.
+    //
+    class ServiceHandler : public std::enable_shared_from_this<ServiceHandler>
     {
     public:
         ServiceHandler(
-            websocketpp::server<websocketpp::config::asio>* server,
+            websocketpp::server<ServiceConfig>* server,
             const char* id,
             JsDebugProtocolHandler protocolHandler,
-            bool breakOnNextLine);
+            bool breakOnNextLine,
+            const OutboundQueueLimits& queueLimits,
+            const CompressionSettings& compression);
         ~ServiceHandler();
 
-        bool RegisterConnection(websocketpp::connection_hdl hdl);
+        const std::string& Id() const;
+
+        // Closes the handler's connections, drops its sessions and disconnects the protocol handler before returning.
+        // Does nothing if the handler is already closed.
+        void Close();
+        bool IsClosed() const;
+
+        // Applies to connections added after the call. Sessions share the queue of the connection they're on.
+        void SetOutboundQueueLimits(const OutboundQueueLimits& queueLimits);
+
+        // The first connection controls the handler; any others (and those that ask for it) only observe. Observers
+        // see every event but none of the responses, and can't send commands. CBOR connections send and receive
+        // binary messages.
+        // Each returns false if the handler has been closed.
+        bool RegisterConnection(websocketpp::connection_hdl hdl, bool observer, bool cbor);
+
+        // Sessions are the multiplexed equivalent of a connection: messages for them are sent on a shared connection
+        // with the session id added, through that connection's queue, and follow the same controller/observer rules.
+        bool AttachSession(
+            websocketpp::connection_hdl hdl,
+            const std::string& sessionId,
+            std::shared_ptr<OutboundQueue> queue);
+        void DetachSession(const std::string& sessionId);
+        bool IsAttached() const;
+
+        // Returns false if the session is only observing, in which case the command is rejected.
+        bool SendSessionCommand(const std::string& sessionId, const char* command);
+
+        // Queues a reply the service makes itself in the essential lane of a connection's queue, so that it's sent in
+        // order with everything else and never between the fragments of another message.
+        static void QueueReply(
+            websocketpp::server<ServiceConfig>* server,
+            websocketpp::connection_hdl hdl,
+            const std::shared_ptr<OutboundQueue>& queue,
+            const char* reply,
+            size_t length);
 
     private:
+        struct Client
+        {
+            websocketpp::connection_hdl hdl;
+
+            // Empty for clients that have a connection of their own.
+            std::string sessionId;
+
+            std::shared_ptr<OutboundQueue> queue;
+
+            // Whether the connection negotiated permessage-deflate in a form the shared compressed messages suit.
+            bool compress;
+
+            // Whether the connection asked for messages in CBOR. Sessions always use JSON.
+            bool cbor;
+        };
+
+        // A response the protocol handler is sending a fragment at a time.
+        struct FragmentedMessage
+        {
+            bool active;
+            bool essential;
+            bool compress;
+            bool compressedStarted;
+            std::vector<Client> connections;
+
+            // Clients that get the message whole once it's complete, with what they've been sent so far.
+            std::vector<std::pair<Client, std::string>> wholeMessages;
+        };
+
         static void CHAKRA_CALLBACK SendResponseCallback(const char* response, void* callbackState);
         void SendResponse(const char* response);
+        static void CHAKRA_CALLBACK SendFragmentCallback(
+            const char* fragment,
+            size_t length,
+            bool final,
+            void* callbackState);
+        void SendFragment(const char* fragment, size_t length, bool final);
+        static void CHAKRA_CALLBACK FlushCallback(void* callbackState);
+        void Flush();
+
+        void OnMessage(websocketpp::connection_hdl hdl, websocketpp::server<ServiceConfig>::message_ptr msg);
+        void OnObserverMessage(
+            websocketpp::connection_hdl hdl,
+            websocketpp::server<ServiceConfig>::message_ptr msg);
+
+        std::vector<Client> GetTargets(bool notification) const;
+        ServiceConfig::message_type::ptr PrepareMessageFor(const Client& client, const char* payload, size_t length);
+
+        void AddClient(
+            websocketpp::connection_hdl hdl,
+            const std::string& sessionId,
+            std::shared_ptr<OutboundQueue> queue,
+            bool observer,
+            bool cbor);
+        void PruneObservers();
+        void Enqueue(
+            const Client& client,
+            ServiceConfig::message_type::ptr message,
+            bool essential);
+        void EnqueueFragment(const Client& client, ServiceConfig::message_type::ptr frame, bool final);
 
-        void OnMessage(websocketpp::connection_hdl hdl, websocketpp::server<websocketpp::config::asio>::message_ptr msg);
+        static void ScheduleFlush(
+            websocketpp::server<ServiceConfig>* server,
+            websocketpp::connection_hdl hdl,
+            std::shared_ptr<OutboundQueue> queue);
+        static void FlushQueue(
+            websocketpp::server<ServiceConfig>* server,
+            websocketpp::connection_hdl hdl,
+            std::shared_ptr<OutboundQueue> queue);
 
-        websocketpp::server<websocketpp::config::asio>* m_server;
+        websocketpp::server<ServiceConfig>* m_server;
         std::string m_id;
-        JsDebugProtocolHandler m_protocolHandler;
         bool m_breakOnNextLine;
 
-        websocketpp::connection_hdl m_hdl;
+        // Held whenever the protocol handler is used from an I/O thread, so that Close can't disconnect it in the
+        // middle. Null once the handler is closed.
+        std::mutex m_protocolHandlerLock;
+        JsDebugProtocolHandler m_protocolHandler;
+
+        // Only used on the engine thread. The buffers hold a message while it's transcoded and compressed, and keep
+        // their capacity from one message to the next.
+        MessageDeflater m_deflater;
+        std::string m_transcoded;
+        std::string m_compressed;
+
+        // Connections are registered on the server thread and messages are sent from the engine thread.
+        mutable std::mutex m_lock;
+        bool m_closed;
+        OutboundQueueLimits m_queueLimits;
+        Client m_controller;
+        std::vector<Client> m_observers;
+
+        // Clients with messages held until the protocol handler's next flush, and the response being sent in
+        // fragments. Only used on the engine thread.
+        std::vector<Client> m_unflushed;
+        FragmentedMessage m_fragmentedMessage;
     };
 }